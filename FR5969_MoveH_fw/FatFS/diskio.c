@@ -32,16 +32,24 @@
 #define CMD9    (0x40+9)    	// SEND_CSD
 #define CMD10    (0x40+10)    	// SEND_CID
 #define CMD12    (0x40+12)    	// STOP_TRANSMISSION
+#define CMD13    (0x40+13)    	// SEND_STATUS, SD_STATUS (ACMD)
 #define CMD16    (0x40+16)    	// SET_BLOCKLEN
 #define CMD17    (0x40+17)    	// READ_SINGLE_BLOCK
 #define CMD18    (0x40+18)    	// READ_MULTIPLE_BLOCK
 #define CMD23    (0x40+23)    	// SET_BLOCK_COUNT
 #define CMD24    (0x40+24)    	// WRITE_BLOCK
 #define CMD25    (0x40+25)    	// WRITE_MULTIPLE_BLOCK
+#define CMD32    (0x40+32)    	// ERASE_WR_BLK_START
+#define CMD33    (0x40+33)    	// ERASE_WR_BLK_END
+#define CMD38    (0x40+38)    	// ERASE
 #define CMD41    (0x40+41)    	// SEND_OP_COND (ACMD)
 #define CMD55    (0x40+55)    	// APP_CMD
 #define CMD58    (0x40+58)    	// READ_OCR
 
+// SPI clock dividers (UCA1BRW), UCA1 runs from SMCLK
+#define SPI_INIT_BRW    (SMCLK_FREQUENCY / 400000)	// identification needs <= 400 kHz
+#define SPI_MIN_BRW     2	// SOMI setup of the eUSCI plus card output delay limit SCLK to ~10 MHz at 3 V
+
 // Peripheral definitions for DK-TM4C123G board
 
 //Pins from MSP430 connected to the SD Card
@@ -78,9 +86,38 @@ static void DESELECT (void){
 
 
 static volatile DSTATUS Stat = STA_NOINIT;    	// Disk status
-static volatile BYTE Timer1, Timer2;    	// 100Hz decrement timer
+static volatile WORD Timer1, Timer2;    	// 100Hz decrement timer, Timer1_A runs while one is set
 static BYTE CardType;            		// b0:MMC, b1:SDC, b2:Block addressing
 static BYTE PowerFlag = 0;     			// Indicates if "power" is on
+static WORD SpiBrw = SPI_INIT_BRW;		// Current SPI clock divider
+static WORD RxSum;				// Checksum of the last block received without buffer
+
+// Timeouts in 10 ms ticks, settable before the next disk access
+DISK_TIMING DiskTiming = {
+	100,					// init: 1 s for ACMD41
+	10,					// read: 100 ms for the data token
+	50,					// busy: 500 ms for programming to finish
+	100,					// erase: 1 s for an erase of up to one AU
+	0, 0
+};
+
+// CSD TRAN_SPEED: transfer rate unit in kHz and time value * 10
+static const DWORD TranUnit[4] = {100, 1000, 10000, 100000};
+static const BYTE TranMult[16] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+
+// SD status AU_SIZE 0xB..0xF in MB, 0x1..0xA are 16 KB << (AU_SIZE - 1)
+static const BYTE AuLarge[5] = {12, 16, 24, 32, 64};
+
+
+// Start the 10 ms tick for Timer1/Timer2 (Platform dependent)
+// Timer1_A on ACLK, stopped again by the ISR once both counters have expired
+static void timer_start (void){
+	if (!(TA1CTL & MC_3)) {
+		TA1CCR0 = 328 - 1;			// 10 ms of 32768 Hz
+		TA1CCTL0 = CCIE;
+		TA1CTL = TASSEL__ACLK | MC__UP | TACLR;
+	}
+}
 
 
 // Transmit a byte to MMC via SPI  (Platform dependent)                 
@@ -119,23 +156,98 @@ static BYTE rcvr_spi (void){
 }
 
 
-static void rcvr_spi_m (BYTE *dst){
-	*dst = rcvr_spi();
+// Clock one dummy byte out and return the byte received before it. Called with
+// TX one byte ahead of RX: TXBUF is refilled while the previous byte shifts.
+static inline BYTE rcvr_step (void){
+	while(!(UCA1IFG & UCTXIFG));
+	UCA1TXBUF = 0xFF;
+	while(!(UCA1IFG & UCRXIFG));
+	return UCA1RXBUF;
+}
+
+
+// Receive a block via SPI, btr must be even  (Platform dependent)
+// Interrupts stay off for the whole block, an ISR between two bytes would let
+// RXBUF overrun. Without buffer only RxSum is computed.
+static void rcvr_block (BYTE *buff, UINT btr){
+	BYTE d;
+	WORD sum = 0;
+
+	uint16_t gie = __get_SR_register() & GIE;	// Save interrupt state
+	__disable_interrupt();
+
+	UCA1IFG &= ~UCRXIFG;				// Ensure RXIFG clear
+	while(!(UCA1IFG & UCTXIFG));			// Wait for TX ready
+	UCA1TXBUF = 0xFF;				// First dummy byte
+	btr -= 2;					// Left for the paired loop, the tail below does the last two
+	if (buff) {
+		while (btr) {				// Two bytes per pass
+			*buff++ = rcvr_step();
+			*buff++ = rcvr_step();
+			btr -= 2;
+		}
+		*buff++ = rcvr_step();
+		while(!(UCA1IFG & UCRXIFG));		// Last byte, nothing left to send
+		*buff = UCA1RXBUF;
+	} else {
+		while (btr) {
+			d = rcvr_step(); sum = (sum << 1 | sum >> 15) + d;
+			d = rcvr_step(); sum = (sum << 1 | sum >> 15) + d;
+			btr -= 2;
+		}
+		d = rcvr_step(); sum = (sum << 1 | sum >> 15) + d;
+		while(!(UCA1IFG & UCRXIFG));
+		d = UCA1RXBUF;
+		RxSum = (sum << 1 | sum >> 15) + d;
+	}
+
+	__bis_SR_register(gie);				// Reload interrupt state
+}
+
+
+// Transmit a block via SPI, btx must be even  (Platform dependent)
+// Only TXIFG is polled per byte, UCBUSY once at the end.
+static void xmit_block (const BYTE *buff, UINT btx){
+	uint16_t gie = __get_SR_register() & GIE;	// Save interrupt state
+	__disable_interrupt();
+
+	do {						// Two bytes per pass
+		while(!(UCA1IFG & UCTXIFG));
+		UCA1TXBUF = *buff++;
+		while(!(UCA1IFG & UCTXIFG));
+		UCA1TXBUF = *buff++;
+	} while (btx -= 2);
+	while(UCA1STATW & UCBUSY);			// Last byte out
+
+	UCA1RXBUF;					// Read to empty RX buffer, clear the overrun
+
+	__bis_SR_register(gie);				// Reload interrupt state
 }
 
 
 // Wait for card ready 
-static BYTE wait_ready (void){
+static BYTE wait_busy (WORD ticks){
 	BYTE res;
+	WORD waited;
 
-	Timer2 = 50;    				/* Wait for ready in timeout of 500ms */
+	Timer2 = ticks;
+	timer_start();
 	rcvr_spi();
 	do
 		res = rcvr_spi();
 	while ((res != 0xFF) && Timer2);
 
+	waited = ticks - Timer2;
+	Timer2 = 0;					/* Done, let the tick stop */
+	if (waited > DiskTiming.worst) DiskTiming.worst = waited;
+	if (res != 0xFF) DiskTiming.expired++;
+
 	return res;
-} // TODO: Enable timeout?
+}
+
+static BYTE wait_ready (void){
+	return wait_busy(DiskTiming.busy);	/* Wait for ready in timeout of 500ms */
+}
 
 
 // Send 80 or so clock transitions with CS and DI held high. This is required after card power up to get it into SPI mode
@@ -177,9 +289,10 @@ static void power_on (void){
 	//Clock polarity select - The inactive state is high
 	//MSB first
 	UCA1CTLW0 |= UCSSEL_2;                          //Use SMCLK, keep RESET
-	UCA1BR0 = 3;                                           //Initial SPI clock must be <400kHz
-	UCA1BR1 = 0;                                            //f_UCxCLK = 1MHz/(3+1) = 250kHz
+	UCA1BRW = SPI_INIT_BRW;                                 //Initial SPI clock must be <400kHz
+	SpiBrw = SPI_INIT_BRW;
 	UCA1CTLW0 &= ~UCSWRST;                                   //Release USCI state machine
+	UCA1IE &= ~(UCRXIE | UCTXIE);                           //Polled, the RTC ISR must not take the bytes
 	UCA1IFG &= ~UCRXIFG;
 
 	// Set DI and CS high and apply more than 74 pulses to SCLK for the card
@@ -190,13 +303,13 @@ static void power_on (void){
 }
 
 
-// Set the SSI speed to the max setting
-static void set_max_speed(void){
+// Change the SPI clock to SMCLK / brw
+static void set_spi_brw(WORD brw){
     UCA1CTLW0 |= UCSWRST;                                    //Put state machine in reset
-    UCA1BR0 = 0;                                            //f_UCxCLK = 1MHz/(0+1) = 1MHz
-    UCA1BR1 = 0;
+    UCA1BRW = brw;
     UCA1CTLW0 &= ~UCSWRST;                                   //Release USCI state machine
-}// TODO: Check speeds
+    SpiBrw = brw;
+}
 
 
 static void power_off (void){
@@ -217,22 +330,22 @@ static BOOL rcvr_datablock (
 ){
 	BYTE token;
 
-	Timer1 = 10;
+	Timer1 = DiskTiming.read;
+	timer_start();
 	do {                            	/* Wait for data packet in timeout of 100ms */
 		token = rcvr_spi();
 	} while ((token == 0xFF) && Timer1);
+	Timer1 = 0;
 
+	if (token == 0xFF) DiskTiming.expired++;
 	if(token != 0xFE) return FALSE;    	/* If not valid data token, retutn with error */
 
-	do {                            	/* Receive the data block into buffer */
-		rcvr_spi_m(buff++);
-		rcvr_spi_m(buff++);
-	} while (btr -= 2);
+	rcvr_block(buff, btr);            	/* Receive the data block into buffer, or checksum it */
 	rcvr_spi();                        	/* Discard CRC */
 	rcvr_spi();
 
 	return TRUE;                    	/* Return with success */
-} // TODO: Timer not implemented
+}
 
 
 /* Send a data packet to MMC */
@@ -241,18 +354,14 @@ static BOOL xmit_datablock (
     const BYTE *buff,    		/* 512 byte data block to be transmitted */
     BYTE token            		/* Data/Stop token */
 ){
-	BYTE resp, wc;
+	BYTE resp;
 
 
 	if (wait_ready() != 0xFF) return FALSE;
 
 	xmit_spi(token);                    /* Xmit data token */
 	if (token != 0xFD) {    		/* Is data token */
-		wc = 0;
-		do {                            /* Xmit the 512 byte data block to MMC */
-		    xmit_spi(*buff++);
-		    xmit_spi(*buff++);
-		} while (--wc);
+		xmit_block(buff, 512);          /* Xmit the 512 byte data block to MMC */
 
 		xmit_spi(0xFF);                 /* CRC (Dummy) */
 		xmit_spi(0xFF);
@@ -342,12 +451,63 @@ static BYTE send_cmd12 (void){
 
 
 
+/* Checksum a sector without buffering it, for the SPI clock check */
+static BOOL rcvr_sum (
+    DWORD sector,        		/* Sector number (LBA) */
+    WORD *sum            		/* Checksum of the sector */
+){
+	BOOL ok;
+
+	if (!(CardType & 4)) sector *= 512;    	/* Convert to byte address if needed */
+
+	SELECT();
+	ok = (send_cmd(CMD17, sector) == 0) && rcvr_datablock(0, 512);
+	DESELECT();
+	rcvr_spi();
+	*sum = RxSum;
+
+	return ok;
+}
+
+
+/* Set the SPI clock to the fastest rate the card (CSD TRAN_SPEED) and the eUSCI allow.
+   Sector 0 is checksummed at the identification clock and read back twice at the new
+   clock, the divider is raised until the readings agree. */
+static void set_max_speed(void){
+	BYTE csd[16];
+	DWORD khz;
+	WORD brw, ref, sum;
+	BOOL ok;
+
+	brw = SPI_MIN_BRW;
+	SELECT();
+	if ((send_cmd(CMD9, 0) == 0) && rcvr_datablock(csd, 16)) {
+		khz = TranUnit[csd[3] & 3] * TranMult[(csd[3] >> 3) & 15] / 10;
+		if (khz) {
+			brw = (WORD)((SMCLK_FREQUENCY / 1000 + khz - 1) / khz);
+			if (brw < SPI_MIN_BRW) brw = SPI_MIN_BRW;
+		}
+	}
+	DESELECT();
+	rcvr_spi();
+
+	ok = rcvr_sum(0, &ref);
+	for (; brw < SPI_INIT_BRW; brw++) {
+		set_spi_brw(brw);
+		if (!ok) break;        		/* No reference, trust the CSD */
+		if (rcvr_sum(0, &sum) && sum == ref && rcvr_sum(0, &sum) && sum == ref) break;
+	}
+	if (brw >= SPI_INIT_BRW) set_spi_brw(SPI_INIT_BRW);
+}
+
+
+
+
 // "Public" Functions -------------------------------------------------------------------------------
 
 
 
 /* Initialize Disk Drive */
-// TODO: Check Timer function
 DSTATUS disk_initialize (
     BYTE drv        				/* Physical drive nmuber (0) */
 ){
@@ -363,7 +523,8 @@ DSTATUS disk_initialize (
 	SELECT();                			/* CS = L */
 	ty = 0;
 	if (send_cmd(CMD0, 0) == 1) {            	/* Enter Idle state */
-		Timer1 = 100;                        	/* Initialization timeout of 1000 msec */
+		Timer1 = DiskTiming.init;              	/* Initialization timeout of 1000 msec */
+		timer_start();
 		if (send_cmd(CMD8, 0x1AA) == 1) {    	/* SDC Ver2+ */
 		    for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();
 		    if (ocr[2] == 0x01 && ocr[3] == 0xAA) {    		/* The card can work at vdd range of 2.7-3.6V */
@@ -388,6 +549,7 @@ DSTATUS disk_initialize (
 			ty = 0;
 		}
 	}
+	Timer1 = 0;
 	CardType = ty;
 	DESELECT();            			/* CS = H */
 	rcvr_spi();           			/* Idle (Release DO) */
@@ -396,6 +558,7 @@ DSTATUS disk_initialize (
 		Stat &= ~STA_NOINIT;        		/* Clear STA_NOINIT */
 		set_max_speed();
 	} else {            			/* Initialization failed */
+		Stat |= STA_NOINIT;        		/* Also after an earlier success, for remounts */
 		power_off();
 	}
 
@@ -452,20 +615,12 @@ DRESULT disk_read (
 
 /* Write Sector(s) */
 #if _READONLY == 0
-DRESULT disk_write (
-    BYTE drv,            			/* Physical drive nmuber (0) */
-    const BYTE *buff,    			/* Pointer to the data to be written */
-    DWORD sector,       			/* Start sector number (LBA) */
-    UINT count           			/* Sector count (1..255) */
+static DRESULT write_blocks (    		/* Card selected, sector converted */
+    const BYTE *buff,    			/* Data of the first block */
+    DWORD sector,       			/* Start sector number (LBA or byte address) */
+    UINT count,           			/* Sector count (1..255) */
+    UINT step            			/* Bytes from one block to the next in buff, 0: same block */
 ){
-	if (drv || !count) return RES_PARERR;
-	if (Stat & STA_NOINIT) return RES_NOTRDY;
-	if (Stat & STA_PROTECT) return RES_WRPRT;
-
-	if (!(CardType & 4)) sector *= 512;    	/* Convert to byte address if needed */
-
-	SELECT();           		 	/* CS = L */
-
 	if (count == 1) {    			/* Single block write */
 		if ((send_cmd(CMD24, sector) == 0)    	/* WRITE_BLOCK */
 		    && xmit_datablock(buff, 0xFE))
@@ -478,17 +633,39 @@ DRESULT disk_write (
 		if (send_cmd(CMD25, sector) == 0) {    	/* WRITE_MULTIPLE_BLOCK */
 		    do {
 			if (!xmit_datablock(buff, 0xFC)) break;
-			buff += 512;
+			buff += step;
 		    } while (--count);
 		    if (!xmit_datablock(0, 0xFD))    	/* STOP_TRAN token */
 			count = 1;
 		}
 	}
 
+	return count ? RES_ERROR : RES_OK;
+}
+
+DRESULT disk_write (
+    BYTE drv,            			/* Physical drive nmuber (0) */
+    const BYTE *buff,    			/* Pointer to the data to be written */
+    DWORD sector,       			/* Start sector number (LBA) */
+    UINT count           			/* Sector count (1..255) */
+){
+	DRESULT res;
+
+
+	if (drv || !count) return RES_PARERR;
+	if (Stat & STA_NOINIT) return RES_NOTRDY;
+	if (Stat & STA_PROTECT) return RES_WRPRT;
+
+	if (!(CardType & 4)) sector *= 512;    	/* Convert to byte address if needed */
+
+	SELECT();           		 	/* CS = L */
+
+	res = write_blocks(buff, sector, count, 512);
+
 	DESELECT();            			/* CS = H */
 	rcvr_spi();            			/* Idle (Release DO) */
 
-	return count ? RES_ERROR : RES_OK;
+	return res;
 }
 #endif /* _READONLY */
 
@@ -503,6 +680,7 @@ DRESULT disk_ioctl (
 	DRESULT res;
 	BYTE n, csd[16], *ptr = buff;
 	WORD csize;
+	DWORD sector, count;
 
 
 	if (drv) return RES_PARERR;
@@ -548,6 +726,29 @@ DRESULT disk_ioctl (
 			    }
 			    break;
 
+			case GET_BLOCK_SIZE :    		/* Get erase block size in unit of sectors (DWORD) */
+			    if ((CardType & 2)            	/* SDC: AU size of the SD status */
+				&& send_cmd(CMD55, 0) <= 1 && send_cmd(CMD13, 0) == 0) {	/* ACMD13 */
+				rcvr_spi();            		/* Second byte of the R2 response */
+				if (rcvr_datablock(csd, 16)) {
+				    for (n = 64 - 16; n; n--) rcvr_spi();	/* Rest of the 64 byte status */
+				    n = csd[10] >> 4;        	/* AU_SIZE, 0: not defined */
+				    if (n) {
+					*(DWORD*)buff = (n <= 10) ? 16UL << n : (DWORD)AuLarge[n - 11] << 11;
+					res = RES_OK;
+				    }
+				}
+			    }
+			    if (res != RES_OK && (send_cmd(CMD9, 0) == 0) && rcvr_datablock(csd, 16)) {	/* Erase sector size of the CSD */
+				if (CardType & 2) {            	/* SDC */
+				    *(DWORD*)buff = (((csd[10] & 63) << 1) + ((WORD)(csd[11] & 128) >> 7) + 1) << ((csd[13] >> 6) - 1);
+				} else {                    	/* MMC */
+				    *(DWORD*)buff = ((WORD)((csd[10] & 124) >> 2) + 1) * (((csd[11] & 3) << 3) + ((csd[11] & 224) >> 5) + 1);
+				}
+				res = RES_OK;
+			    }
+			    break;
+
 			case GET_SECTOR_SIZE :    		/* Get sectors on the disk (WORD) */
 			    *(WORD*)buff = 512;
 			    res = RES_OK;
@@ -558,6 +759,21 @@ DRESULT disk_ioctl (
 				res = RES_OK;
 			    break;
 
+			case CTRL_TRIM :    			/* Erase a block of sectors (DWORD[2]: first and last sector) */
+			    if (!(CardType & 2)) break;    	/* SDC only, MMC erases whole erase groups */
+			    if ((send_cmd(CMD9, 0) != 0) || !rcvr_datablock(csd, 16)) break;
+			    if (!(csd[0] >> 6) && !(csd[10] & 0x40)) break;	/* SDC ver 1.XX without ERASE_BLK_EN */
+			    sector = ((DWORD*)buff)[0];
+			    count = ((DWORD*)buff)[1];
+			    if (!(CardType & 4)) {        	/* Byte addressing */
+				sector *= 512;
+				count *= 512;
+			    }
+			    if (send_cmd(CMD32, sector) == 0 && send_cmd(CMD33, count) == 0
+				&& send_cmd(CMD38, 0) == 0 && wait_busy(DiskTiming.erase) == 0xFF)
+				res = RES_OK;
+			    break;
+
 			case MMC_GET_CSD :    			/* Receive CSD as a data block (16 bytes) */
 			    if (send_cmd(CMD9, 0) == 0       	/* READ_CSD */
 				&& rcvr_datablock(ptr, 16))
@@ -576,6 +792,42 @@ DRESULT disk_ioctl (
 				    *ptr++ = rcvr_spi();
 				res = RES_OK;
 			    }
+			    break;
+
+			case MMC_GET_SPEED :    		/* Get the SPI clock in kHz (DWORD) */
+			    *(DWORD*)buff = SMCLK_FREQUENCY / 1000 / SpiBrw;
+			    res = RES_OK;
+			    break;
+
+			case MMC_XMIT_TEST :    		/* Clock 512 bytes of buff out with CS high, the card ignores them */
+			    DESELECT();
+			    xmit_block(ptr, 512);
+			    res = RES_OK;
+			    break;
+
+			case MMC_READ_TEST :    		/* Read DWORD[1] sectors from DWORD[0] without storing them */
+			    sector = ((DWORD*)buff)[0];
+			    count = ((DWORD*)buff)[1];
+			    if (!(CardType & 4)) sector *= 512;
+			    if (count && send_cmd(CMD18, sector) == 0) {
+				do {
+				    if (!rcvr_datablock(0, 512)) break;
+				} while (--count);
+				send_cmd12();
+				if (!count) res = RES_OK;
+			    }
+			    break;
+
+			case MMC_WRITE_TEST :    		/* Write DWORD[1] sectors from DWORD[0] in one command, each with the 512 bytes of buff */
+			    if (Stat & STA_PROTECT) {
+				res = RES_WRPRT;
+				break;
+			    }
+			    sector = ((DWORD*)buff)[0];
+			    count = ((DWORD*)buff)[1];
+			    if (!(CardType & 4)) sector *= 512;
+			    if (count && count < 256) res = write_blocks(ptr, sector, (UINT)count, 0);
+			    break;
 
 			//        case MMC_GET_TYPE :    /* Get card type flags (1 byte) */
 			//            *ptr = CardType;
@@ -597,10 +849,8 @@ DRESULT disk_ioctl (
 
 /* Device Timer Interrupt Procedure  (Platform dependent)                */
 /* This function must be called in period of 10ms                        */
-// TODO: Timer function, CHECK!
 void disk_timerproc (void){
-	//    BYTE n, s;
-	BYTE n;
+	WORD n;
 
 
 	n = Timer1;                        /* 100Hz decrement timer */
@@ -608,6 +858,13 @@ void disk_timerproc (void){
 	n = Timer2;
 	if (n) Timer2 = --n;
 
+	if (!Timer1 && !Timer2) TA1CTL &= ~MC_3;	/* Nothing to time, stop the tick */
+}
+
+
+#pragma vector = TIMER1_A0_VECTOR
+__interrupt void TIMER1_A0_ISR(void){
+	disk_timerproc();
 }
 
 /*---------------------------------------------------------*/
@@ -28,6 +28,19 @@ typedef enum {
 } DRESULT;
 
 
+/* Timeouts of the SPI card driver in 10 ms ticks, and what they caught */
+typedef struct {
+	WORD	init;		/* Card initialization (ACMD41) */
+	WORD	read;		/* Data token after a read command */
+	WORD	busy;		/* Card busy before a command or after a write */
+	WORD	erase;		/* Card busy after an erase (CTRL_TRIM) */
+	WORD	expired;	/* Timeouts that expired since boot */
+	WORD	worst;		/* Longest busy wait seen */
+} DISK_TIMING;
+
+extern DISK_TIMING DiskTiming;
+
+
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
 
@@ -37,6 +50,7 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+void disk_timerproc (void);
 
 
 /* Disk Status Bits (DSTATUS) */
@@ -67,6 +81,10 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define MMC_GET_CID			12	/* Get CID */
 #define MMC_GET_OCR			13	/* Get OCR */
 #define MMC_GET_SDSTAT		14	/* Get SD status */
+#define MMC_GET_SPEED		15	/* Get SPI clock in kHz */
+#define MMC_READ_TEST		16	/* Read sectors without storing them, for throughput tests */
+#define MMC_XMIT_TEST		17	/* Clock a sector out with the card deselected, for cycle counts */
+#define MMC_WRITE_TEST		18	/* Write one block to a run of sectors, for write latency tests */
 
 /* ATA/CF specific ioctl command */
 #define ATA_GET_REV			20	/* Get F/W revision */
@@ -46,6 +46,14 @@
 #define	ABORT(fs, res)		{ fp->err = (BYTE)(res); LEAVE_FF(fs, res); }
 
 
+/* Cluster allocation of a file */
+#if !_FS_READONLY && _FS_AUALLOC
+#define	CREATE_CHAIN(fp, clst)	(((fp)->flag & FA_ALIGN) ? create_chain_au((fp)->fs, clst) : create_chain((fp)->fs, clst))
+#else
+#define	CREATE_CHAIN(fp, clst)	create_chain((fp)->fs, clst)
+#endif
+
+
 /* Definitions of sector size */
 #if (_MAX_SS < _MIN_SS) || (_MAX_SS != 512 && _MAX_SS != 1024 && _MAX_SS != 2048 && _MAX_SS != 4096) || (_MIN_SS != 512 && _MIN_SS != 1024 && _MIN_SS != 2048 && _MIN_SS != 4096)
 #error Wrong sector size configuration
@@ -401,7 +409,21 @@ typedef struct {
 #error Wrong _VOLUMES setting
 #endif
 static FATFS *FatFs[_VOLUMES];	/* Pointer to the file system objects (logical drives) */
+#if _FS_STATS
+FFSTATS FfStats;				/* Write path counters */
+#endif
 static WORD Fsid;				/* File system mount ID */
+#if !_FS_TINY && _FS_BUFPOOL
+static FIL* PoolOwner[_FS_BUFPOOL];	/* File holding each pool buffer (0:free) */
+static WORD PoolUse[_FS_BUFPOOL];	/* Last use of each pool buffer */
+static WORD PoolClock;				/* Use counter */
+#endif
+#if !_FS_READONLY && _FS_WINCACHE
+static FATFS* WinCacheFs;			/* Volume bound to FfWinCache (0:cache bypassed) */
+#endif
+#if !_FS_READONLY && _FS_GEOCACHE
+static FATFS* GeoCacheFs;			/* Volume described by FfGeoCache */
+#endif
 
 #if _FS_RPATH && _VOLUMES >= 2
 static BYTE CurrVol;			/* Current drive */
@@ -652,27 +674,182 @@ void clear_lock (	/* Clear lock entries of the volume */
 /*-----------------------------------------------------------------------*/
 #if !_FS_READONLY
 static
-FRESULT sync_window (
-	FATFS* fs		/* File system object */
+FRESULT write_sect (
+	FATFS* fs,		/* File system object */
+	const BYTE* buff,	/* Sector data */
+	DWORD wsect		/* Sector number */
 )
 {
-	DWORD wsect;
 	UINT nf;
+
+
+	if (disk_write(fs->drv, buff, wsect, 1) != RES_OK)
+		return FR_DISK_ERR;
+#if _FS_STATS
+	FfStats.meta++;
+#endif
+	if (wsect - fs->fatbase < fs->fsize) {		/* Is it in the FAT area? */
+		for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
+			wsect += fs->fsize;
+			disk_write(fs->drv, buff, wsect, 1);
+#if _FS_STATS
+			FfStats.meta++;
+#endif
+		}
+	}
+	return FR_OK;
+}
+
+
+#if _FS_WINCACHE
+static
+UINT cache_find (	/* Slot holding the sector, _FS_WINCACHE:not cached */
+	DWORD sector	/* Sector number */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_WINCACHE && FfWinCache.sect[i] != sector; i++) ;
+	return i;
+}
+
+
+static
+FRESULT cache_write (	/* Write back a dirty slot */
+	FATFS* fs,		/* File system object */
+	UINT i			/* Slot */
+)
+{
+	if (write_sect(fs, FfWinCache.buf[i], FfWinCache.sect[i]) != FR_OK)
+		return FR_DISK_ERR;
+	FfWinCache.dirty[i] = 0;
+	return FR_OK;
+}
+
+
+static
+void cache_drop (	/* Forget the slots within a sector range */
+	DWORD sect,		/* Start sector */
+	UINT n			/* Number of sectors */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_WINCACHE; i++) {
+		if (FfWinCache.sect[i] - sect < n) {
+			FfWinCache.dirty[i] = 0;
+			FfWinCache.sect[i] = 0xFFFFFFFF;
+		}
+	}
+}
+
+
+/* Copy a dirty window into the cache. The copy is made in a slot that holds
+/  no pending data and marked dirty when complete, the slot with the previous
+/  copy is released after that, so a power failure at any point leaves either
+/  copy intact. Two dirty copies of a sector are told apart by their age. */
+static
+FRESULT park_window (
+	FATFS* fs		/* File system object */
+)
+{
+	UINT i, h, v;
+	WORD age, a;
 	FRESULT res = FR_OK;
 
 
-	if (fs->wflag) {	/* Write back the sector if it is dirty */
-		wsect = fs->winsect;	/* Current sector number */
-		if (disk_write(fs->drv, fs->win, wsect, 1) != RES_OK) {
-			res = FR_DISK_ERR;
-		} else {
+	if (fs->wflag) {
+		h = cache_find(fs->winsect);
+		v = _FS_WINCACHE; age = 0;
+		for (i = 0; i < _FS_WINCACHE; i++) {	/* Find a slot: empty, least recent clean, least recent dirty */
+			if (i == h && FfWinCache.dirty[i]) continue;
+			if (FfWinCache.sect[i] == 0xFFFFFFFF) { v = i; break; }
+			a = FfWinCache.clock - FfWinCache.age[i];
+			if (v == _FS_WINCACHE || FfWinCache.dirty[v] > FfWinCache.dirty[i]
+				|| (FfWinCache.dirty[v] == FfWinCache.dirty[i] && a > age)) {
+				v = i; age = a;
+			}
+		}
+		if (v == _FS_WINCACHE) v = h;			/* Single slot with the previous copy */
+		if (FfWinCache.dirty[v]) res = cache_write(fs, v);	/* Cache is full of changes */
+		if (res == FR_OK) {
+			FfWinCache.sect[v] = 0xFFFFFFFF;
+			mem_cpy(FfWinCache.buf[v], fs->win, SS(fs));
+			FfWinCache.sect[v] = fs->winsect;
+			FfWinCache.age[v] = ++FfWinCache.clock;
+			FfWinCache.dirty[v] = 1;			/* The new copy is valid */
+			if (h < _FS_WINCACHE && h != v) {	/* Release the previous copy */
+				FfWinCache.dirty[h] = 0;
+				FfWinCache.sect[h] = 0xFFFFFFFF;
+			}
 			fs->wflag = 0;
-			if (wsect - fs->fatbase < fs->fsize) {		/* Is it in the FAT area? */
-				for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
-					wsect += fs->fsize;
-					disk_write(fs->drv, fs->win, wsect, 1);
-				}
+		}
+	}
+	return res;
+}
+
+
+/* Bind the cache to the volume being mounted. Sectors left dirty by the same
+/  volume on the same card are written first, newest copy only, the cache of
+/  another volume is discarded. Cards written from one image share serial
+/  number and FAT start, so the CID has to match as well. */
+static
+FRESULT cache_mount (
+	FATFS* fs,		/* File system object */
+	DWORD vsn		/* Volume serial number */
+)
+{
+	UINT i, j;
+	BYTE cid[16];
+	DWORD fatbase = fs->fatbase;
+
+
+	if (disk_ioctl(fs->drv, MMC_GET_CID, cid) != RES_OK) {
+		mem_set(cid, 0, sizeof(cid));
+		fatbase = 0;					/* Card unknown, the next mount discards the cache */
+	}
+	if (FfWinCache.volid == vsn && FfWinCache.fatbase == fatbase && fatbase
+		&& !mem_cmp(FfWinCache.cid, cid, sizeof(cid))) {
+		for (i = 0; i < _FS_WINCACHE; i++) {
+			if (!FfWinCache.dirty[i]) continue;
+			for (j = 0; j < _FS_WINCACHE; j++) {	/* Skip an older copy of the same sector */
+				if (j != i && FfWinCache.dirty[j] && FfWinCache.sect[j] == FfWinCache.sect[i]
+					&& (short)(FfWinCache.age[j] - FfWinCache.age[i]) > 0) break;
 			}
+			if (j == _FS_WINCACHE && cache_write(fs, i) != FR_OK)
+				return FR_DISK_ERR;
+		}
+	}
+	for (i = 0; i < _FS_WINCACHE; i++) {
+		FfWinCache.dirty[i] = 0;
+		FfWinCache.sect[i] = 0xFFFFFFFF;
+	}
+	FfWinCache.volid = vsn;
+	FfWinCache.fatbase = fatbase;
+	mem_cpy(FfWinCache.cid, cid, sizeof(cid));
+	WinCacheFs = fs;
+	return FR_OK;
+}
+#endif
+
+
+static
+FRESULT sync_window (	/* Write the window to the medium if it is dirty */
+	FATFS* fs		/* File system object */
+)
+{
+	FRESULT res = FR_OK;
+
+
+	if (fs->wflag) {	/* Write back the sector if it is dirty */
+		res = write_sect(fs, fs->win, fs->winsect);
+		if (res == FR_OK) {
+			fs->wflag = 0;
+#if _FS_WINCACHE
+			if (WinCacheFs == fs) cache_drop(fs->winsect, 1);	/* Cached copy is older */
+#endif
 		}
 	}
 	return res;
@@ -687,10 +864,25 @@ FRESULT move_window (
 )
 {
 	FRESULT res = FR_OK;
+#if !_FS_READONLY && _FS_WINCACHE
+	UINT i;
+#endif
 
 
 	if (sector != fs->winsect) {	/* Window offset changed? */
 #if !_FS_READONLY
+#if _FS_WINCACHE
+		if (WinCacheFs == fs) {
+			res = park_window(fs);		/* Keep changes in the cache */
+			i = cache_find(sector);
+			if (res == FR_OK && i < _FS_WINCACHE) {	/* Fill sector window from the cache */
+				mem_cpy(fs->win, FfWinCache.buf[i], SS(fs));
+				FfWinCache.age[i] = ++FfWinCache.clock;
+				fs->winsect = sector;
+				return FR_OK;
+			}
+		} else
+#endif
 		res = sync_window(fs);		/* Write-back changes */
 #endif
 		if (res == FR_OK) {			/* Fill sector window with new data */
@@ -719,6 +911,32 @@ FRESULT sync_fs (	/* FR_OK: successful, FR_DISK_ERR: failed */
 	FRESULT res;
 
 
+#if _FS_GEOCACHE
+	if (GeoCacheFs == fs) {				/* Hints for the next mount */
+		FfGeoCache.last_clust = fs->last_clust;
+#if _FS_AUALLOC
+		FfGeoCache.au_last = fs->au_last;
+#endif
+	}
+#endif
+#if _FS_WINCACHE
+	if (WinCacheFs == fs) {
+		res = park_window(fs);
+		if (res == FR_OK && fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {
+			/* Create FSINFO structure in the window, it goes to the cache with the next move */
+			mem_set(fs->win, 0, SS(fs));
+			ST_WORD(fs->win + BS_55AA, 0xAA55);
+			ST_DWORD(fs->win + FSI_LeadSig, 0x41615252);
+			ST_DWORD(fs->win + FSI_StrucSig, 0x61417272);
+			ST_DWORD(fs->win + FSI_Free_Count, fs->free_clust);
+			ST_DWORD(fs->win + FSI_Nxt_Free, fs->last_clust);
+			fs->winsect = fs->volbase + 1;
+			fs->wflag = 1;
+			fs->fsi_flag = 0;
+		}
+		return res;		/* Written back by f_flush() or when the cache is full */
+	}
+#endif
 	res = sync_window(fs);
 	if (res == FR_OK) {
 		/* Update FSINFO sector if needed */
@@ -733,6 +951,9 @@ FRESULT sync_fs (	/* FR_OK: successful, FR_DISK_ERR: failed */
 			/* Write it into the FSINFO sector */
 			fs->winsect = fs->volbase + 1;
 			disk_write(fs->drv, fs->win, fs->winsect, 1);
+#if _FS_STATS
+			FfStats.meta++;
+#endif
 			fs->fsi_flag = 0;
 		}
 		/* Make sure that no pending write process in the physical drive */
@@ -982,6 +1203,9 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 		res = put_fat(fs, clst, ncl);	/* Link it to the previous one if needed */
 	}
 	if (res == FR_OK) {
+#if _FS_WINCACHE
+		if (WinCacheFs == fs) cache_drop(clust2sect(fs, ncl), fs->csize);	/* Sectors of a freed directory */
+#endif
 		fs->last_clust = ncl;			/* Update FSINFO */
 		if (fs->free_clust != 0xFFFFFFFF) {
 			fs->free_clust--;
@@ -993,6 +1217,73 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 
 	return ncl;		/* Return new cluster number or error code */
 }
+
+
+#if _FS_AUALLOC
+static
+DWORD find_au (	/* 0:None, 1:Internal error, 0xFFFFFFFF:Disk error, >=2:First cluster of the free end of an AU */
+	FATFS* fs,			/* File system object */
+	DWORD clst			/* Search from the AU of this cluster on */
+)
+{
+	DWORD scl, ncl, cs;
+
+
+	scl = fs->au0;		/* Top of the AU */
+	if (clst >= scl) scl = clst - (clst - fs->au0) % fs->au;
+	for ( ; scl + fs->au <= fs->n_fatent; scl += fs->au) {
+		for (ncl = scl + fs->au; ncl > scl; ncl--) {	/* Free clusters from the end of the AU down */
+			cs = get_fat(fs, ncl - 1);
+			if (cs == 0xFFFFFFFF || cs == 1) return cs;
+			if (cs != 0) break;
+		}
+		if (ncl < scl + fs->au) return ncl;	/* The card can go on writing the AU in order from here */
+	}
+	return 0;
+}
+
+
+static
+DWORD create_chain_au (	/* create_chain() for FA_ALIGN files */
+	FATFS* fs,			/* File system object */
+	DWORD clst			/* Cluster# to stretch. 0 means create a new chain. */
+)
+{
+	DWORD cs, ncl, hint;
+	FRESULT res;
+
+
+	if (!fs->au) return create_chain(fs, clst);
+
+	hint = fs->last_clust;				/* Other files keep filling the gaps they came from */
+	if (clst && (clst + 1 < fs->au0 || (clst + 1 - fs->au0) % fs->au)) {
+		ncl = create_chain(fs, clst);	/* Not crossing an AU boundary */
+	} else {
+		if (clst) {
+			cs = get_fat(fs, clst);			/* Check the cluster status */
+			if (cs < 2) return 1;			/* Invalid value */
+			if (cs == 0xFFFFFFFF) return cs;	/* A disk error occurred */
+			if (cs < fs->n_fatent) return cs;	/* It is already followed by next cluster */
+		}
+		ncl = find_au(fs, clst ? clst : fs->au_last);
+		if (ncl == 0) ncl = find_au(fs, 0);	/* Wrap around */
+		if (ncl == 1 || ncl == 0xFFFFFFFF) return ncl;
+		if (ncl == 0) {						/* No AU with a free end left, any cluster until the next mount */
+			fs->au = 0;
+			return create_chain(fs, clst);
+		}
+		fs->last_clust = ncl - 1;			/* Let create_chain() take the cluster found */
+		ncl = create_chain(fs, 0);
+		if (ncl >= 2 && ncl != 0xFFFFFFFF && clst) {
+			res = put_fat(fs, clst, ncl);	/* Link it to the previous one */
+			if (res != FR_OK) ncl = (res == FR_DISK_ERR) ? 0xFFFFFFFF : 1;
+		}
+	}
+	if (ncl >= 2 && ncl != 0xFFFFFFFF) fs->au_last = ncl;
+	fs->last_clust = hint;
+	return ncl;
+}
+#endif
 #endif /* !_FS_READONLY */
 
 
@@ -2166,6 +2457,12 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 	WORD nrsv;
 	FATFS *fs;
 	UINT i;
+#if !_FS_READONLY && (_FS_WINCACHE || _FS_GEOCACHE)
+	DWORD vid;
+#endif
+#if !_FS_READONLY && _FS_GEOCACHE
+	BYTE geo;
+#endif
 
 
 	/* Get logical drive number from the path name */
@@ -2192,6 +2489,13 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 	/* The file system object is not valid. */
 	/* Following code attempts to mount the volume. (analyze BPB and initialize the fs object) */
 
+#if !_FS_READONLY && _FS_WINCACHE
+	if (WinCacheFs == fs) park_window(fs);	/* Keep a dirty window for the same volume */
+	WinCacheFs = 0;						/* Bypass the cache until the volume is known */
+#endif
+#if !_FS_READONLY && _FS_GEOCACHE
+	GeoCacheFs = 0;
+#endif
 	fs->fs_type = 0;					/* Clear the file system object */
 	fs->drv = LD2PD(vol);				/* Bind the logical drive and a physical drive */
 	stat = disk_initialize(fs->drv);	/* Initialize the physical drive */
@@ -2205,6 +2509,11 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #endif
 	/* Find an FAT partition on the drive. Supports only generic partitioning, FDISK and SFD. */
 	bsect = 0;
+#if !_FS_READONLY && _FS_GEOCACHE
+	geo = FfGeoCache.valid						/* Same card as at the last mount? (window is free here) */
+		&& disk_ioctl(fs->drv, MMC_GET_CID, fs->win) == RES_OK
+		&& !mem_cmp(fs->win, FfGeoCache.cid, sizeof(FfGeoCache.cid));
+#endif
 	fmt = check_fs(fs, bsect);					/* Load sector 0 and check if it is an FAT boot sector as SFD */
 	if (fmt == 1 || (!fmt && (LD2PT(vol)))) {	/* Not an FAT boot sector or forced partition number */
 		for (i = 0; i < 4; i++) {			/* Get partition offset */
@@ -2276,9 +2585,40 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 	if (fs->fsize < (szbfat + (SS(fs) - 1)) / SS(fs))	/* (BPB_FATSz must not be less than the size needed) */
 		return FR_NO_FILESYSTEM;
 
+#if !_FS_READONLY && (_FS_WINCACHE || _FS_GEOCACHE)
+	vid = LD_DWORD(fs->win + (fmt == FS_FAT32 ? BS_VolID32 : BS_VolID));	/* Volume serial number */
+#endif
+#if !_FS_READONLY && _FS_GEOCACHE
+	if (!geo || vid != FfGeoCache.volid || bsect != FfGeoCache.bsect) {	/* Partitioned or formatted again, the hints are void */
+		geo = 0;
+		FfGeoCache.valid = 0;
+	}
+#endif
+#if !_FS_READONLY && _FS_WINCACHE
+	/* Write back or discard the cached sectors */
+	if (cache_mount(fs, vid) != FR_OK)
+		return FR_DISK_ERR;
+#endif
+
 #if !_FS_READONLY
 	/* Initialize cluster allocation information */
 	fs->last_clust = fs->free_clust = 0xFFFFFFFF;
+#if _FS_AUALLOC
+	fs->au = 0;							/* Allocation unit in clusters */
+#if _FS_GEOCACHE
+	if (geo)
+		szbfat = FfGeoCache.aus;		/* AU size of this card */
+	else
+#endif
+	if (disk_ioctl(fs->drv, GET_BLOCK_SIZE, &szbfat) != RES_OK)
+		szbfat = 0;
+	if (szbfat > fs->csize && szbfat % fs->csize == 0) {
+		fs->au = szbfat / fs->csize;
+		szbfat = (szbfat - fs->database % szbfat) % szbfat;	/* Sectors up to the first AU boundary */
+		fs->au0 = 2 + (szbfat + fs->csize - 1) / fs->csize;
+		fs->au_last = 0;
+	}
+#endif
 
 	/* Get fsinfo if available */
 	fs->fsi_flag = 0x80;
@@ -2301,6 +2641,28 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 		}
 	}
 #endif
+#if _FS_GEOCACHE
+	if (geo) {							/* Go on allocating where the last mount left off */
+		if (fs->last_clust < 2 || fs->last_clust >= fs->n_fatent)
+			fs->last_clust = FfGeoCache.last_clust;
+#if _FS_AUALLOC
+		if (fs->au && FfGeoCache.au_last < fs->n_fatent)
+			fs->au_last = FfGeoCache.au_last;
+#endif
+	} else if (disk_ioctl(fs->drv, MMC_GET_CID, FfGeoCache.cid) == RES_OK) {	/* Remember the card and its volume */
+		FfGeoCache.volid = vid;
+		FfGeoCache.bsect = bsect;
+#if _FS_AUALLOC
+		FfGeoCache.aus = fs->au * fs->csize;
+#else
+		FfGeoCache.aus = 0;
+#endif
+		FfGeoCache.last_clust = fs->last_clust;
+		FfGeoCache.au_last = 0;
+		FfGeoCache.valid = 1;
+	}
+	GeoCacheFs = fs;
+#endif
 #endif
 	fs->fs_type = fmt;	/* FAT sub-type */
 	fs->id = ++Fsid;	/* File system mount ID */
@@ -2343,6 +2705,73 @@ FRESULT validate (	/* FR_OK(0): The object is valid, !=0: Invalid */
 
 
 
+#if !_FS_TINY && _FS_BUFPOOL
+/*-----------------------------------------------------------------------*/
+/* Sector buffer pool                                                    */
+/*-----------------------------------------------------------------------*/
+/* A file holds a buffer while fp->buf points to it. A dirty buffer is
+/  always held, so write-backs of a dirty buffer need no lease. */
+
+static
+FRESULT lease_buf (	/* FR_OK(0):succeeded, !=0:error */
+	FIL* fp,		/* File object to get a buffer */
+	int ld			/* 1:Load fp->dsect into a new buffer */
+)
+{
+	UINT i, n = 0;
+	FIL* ow;
+
+
+	for (i = 0; i < _FS_BUFPOOL; i++) {
+		if (PoolOwner[i] == fp && fp->buf == FfPool[i]) {	/* Still held */
+			PoolUse[i] = ++PoolClock;
+			return FR_OK;
+		}
+		if (PoolOwner[n] && (!PoolOwner[i] || (WORD)(PoolClock - PoolUse[i]) > (WORD)(PoolClock - PoolUse[n])))
+			n = i;		/* Free or least recently used buffer */
+	}
+	ow = PoolOwner[n];
+	if (ow) {			/* Take the buffer from its file */
+		if (ow->flag & FA__DIRTY) {		/* Write-back, the data of a stale file are dropped */
+			if (validate(ow) != FR_INVALID_OBJECT &&
+				disk_write(ow->fs->drv, ow->buf, ow->dsect, 1) != RES_OK)
+				return FR_DISK_ERR;
+			ow->flag &= ~FA__DIRTY;
+		}
+		ow->buf = 0;
+#if _FS_STATS
+		FfStats.evicts++;
+#endif
+	}
+	PoolOwner[n] = fp;
+	PoolUse[n] = ++PoolClock;
+	fp->buf = FfPool[n];
+	if (ld && fp->dsect && disk_read(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK) {
+		fp->dsect = 0;	/* Buffer holds no sector */
+		return FR_DISK_ERR;
+	}
+	return FR_OK;
+}
+
+
+static
+void return_buf (
+	FIL* fp			/* File object to give back its buffer, contents are dropped */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_BUFPOOL; i++) {
+		if (PoolOwner[i] == fp) PoolOwner[i] = 0;
+	}
+	fp->buf = 0;
+}
+#endif
+
+
+
+
 /*--------------------------------------------------------------------------
 
    Public Functions
@@ -2419,10 +2848,17 @@ FRESULT f_open (
 
 	if (!fp) return FR_INVALID_OBJECT;
 	fp->fs = 0;			/* Clear file object */
+#if !_FS_TINY && _FS_BUFPOOL
+	return_buf(fp);		/* Drop a buffer left from a previous use */
+#endif
 
 	/* Get logical drive number */
 #if !_FS_READONLY
+#if _FS_AUALLOC
+	mode &= FA_READ | FA_WRITE | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS | FA_CREATE_NEW | FA_ALIGN;
+#else
 	mode &= FA_READ | FA_WRITE | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS | FA_CREATE_NEW;
+#endif
 	res = find_volume(&dj.fs, &path, (BYTE)(mode & ~FA_READ));
 #else
 	mode &= FA_READ;
@@ -2610,6 +3046,10 @@ FRESULT f_read (
 						ABORT(fp->fs, FR_DISK_ERR);
 					fp->flag &= ~FA__DIRTY;
 				}
+#endif
+#if _FS_BUFPOOL
+				if (lease_buf(fp, 0) != FR_OK)
+					ABORT(fp->fs, FR_DISK_ERR);
 #endif
 				if (disk_read(fp->fs->drv, fp->buf, sect, 1) != RES_OK)	/* Fill sector cache */
 					ABORT(fp->fs, FR_DISK_ERR);
@@ -2624,6 +3064,10 @@ FRESULT f_read (
 			ABORT(fp->fs, FR_DISK_ERR);
 		mem_cpy(rbuff, &fp->fs->win[fp->fptr % SS(fp->fs)], rcnt);	/* Pick partial sector */
 #else
+#if _FS_BUFPOOL
+		if (lease_buf(fp, 1) != FR_OK)					/* Reload the sector if the buffer was taken */
+			ABORT(fp->fs, FR_DISK_ERR);
+#endif
 		mem_cpy(rbuff, &fp->buf[fp->fptr % SS(fp->fs)], rcnt);	/* Pick partial sector */
 #endif
 	}
@@ -2654,6 +3098,9 @@ FRESULT f_write (
 
 
 	*bw = 0;	/* Clear write byte counter */
+#if _FS_STATS
+	FfStats.writes++;
+#endif
 
 	res = validate(fp);						/* Check validity */
 	if (res != FR_OK) LEAVE_FF(fp->fs, res);
@@ -2671,14 +3118,14 @@ FRESULT f_write (
 				if (fp->fptr == 0) {		/* On the top of the file? */
 					clst = fp->sclust;		/* Follow from the origin */
 					if (clst == 0)			/* When no cluster is allocated, */
-						clst = create_chain(fp->fs, 0);	/* Create a new cluster chain */
+						clst = CREATE_CHAIN(fp, 0);	/* Create a new cluster chain */
 				} else {					/* Middle or end of the file */
 #if _USE_FASTSEEK
 					if (fp->cltbl)
 						clst = clmt_clust(fp, fp->fptr);	/* Get cluster# from the CLMT */
 					else
 #endif
-						clst = create_chain(fp->fs, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+						clst = CREATE_CHAIN(fp, fp->clust);	/* Follow or stretch cluster chain on the FAT */
 				}
 				if (clst == 0) break;		/* Could not allocate a new cluster (disk full) */
 				if (clst == 1) ABORT(fp->fs, FR_INT_ERR);
@@ -2711,8 +3158,12 @@ FRESULT f_write (
 					mem_cpy(fp->fs->win, wbuff + ((fp->fs->winsect - sect) * SS(fp->fs)), SS(fp->fs));
 					fp->fs->wflag = 0;
 				}
+#else
+#if _FS_BUFPOOL
+				if (fp->buf && fp->dsect - sect < cc) { /* Refill a held sector cache, a taken one is reloaded from the disk */
 #else
 				if (fp->dsect - sect < cc) { /* Refill sector cache if it gets invalidated by the direct write */
+#endif
 					mem_cpy(fp->buf, wbuff + ((fp->dsect - sect) * SS(fp->fs)), SS(fp->fs));
 					fp->flag &= ~FA__DIRTY;
 				}
@@ -2728,9 +3179,16 @@ FRESULT f_write (
 			}
 #else
 			if (fp->dsect != sect) {		/* Fill sector cache with file data */
+#if _FS_BUFPOOL
+				if (lease_buf(fp, 0) != FR_OK)
+					ABORT(fp->fs, FR_DISK_ERR);
+#endif
 				if (fp->fptr < fp->fsize &&
 					disk_read(fp->fs->drv, fp->buf, sect, 1) != RES_OK)
 						ABORT(fp->fs, FR_DISK_ERR);
+#if _FS_STATS
+				if (fp->fptr < fp->fsize) FfStats.fills++;
+#endif
 			}
 #endif
 			fp->dsect = sect;
@@ -2743,7 +3201,14 @@ FRESULT f_write (
 		mem_cpy(&fp->fs->win[fp->fptr % SS(fp->fs)], wbuff, wcnt);	/* Fit partial sector */
 		fp->fs->wflag = 1;
 #else
+#if _FS_BUFPOOL
+		if (lease_buf(fp, 1) != FR_OK)				/* Reload the sector if the buffer was taken */
+			ABORT(fp->fs, FR_DISK_ERR);
+#endif
 		mem_cpy(&fp->buf[fp->fptr % SS(fp->fs)], wbuff, wcnt);	/* Fit partial sector */
+#if _FS_STATS
+		FfStats.copied += wcnt;
+#endif
 		fp->flag |= FA__DIRTY;
 #endif
 	}
@@ -2806,6 +3271,80 @@ FRESULT f_sync (
 
 
 
+#if !_FS_READONLY && _FS_WINCACHE
+/*-----------------------------------------------------------------------*/
+/* Write Back Cached FAT and Directory Sectors                           */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_flush (
+	const TCHAR* path	/* Path name of the logical drive number */
+)
+{
+	FATFS *fs;
+	FRESULT res;
+	UINT i;
+
+
+	res = find_volume(&fs, &path, 1);
+	if (res == FR_OK) res = sync_fs(fs);	/* Park the window, FSINFO goes to the window */
+	if (res == FR_OK) res = sync_window(fs);
+	for (i = 0; res == FR_OK && i < _FS_WINCACHE; i++) {
+		if (FfWinCache.dirty[i]) res = cache_write(fs, i);
+	}
+	if (res == FR_OK && disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK)
+		res = FR_DISK_ERR;
+
+	LEAVE_FF(fs, res);
+}
+
+#endif /* !_FS_READONLY && _FS_WINCACHE */
+
+
+
+
+#if !_FS_READONLY && _FS_AUALLOC
+/*-----------------------------------------------------------------------*/
+/* Erase the Free Ends of the AUs the Next FA_ALIGN Chain Takes          */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_preerase (
+	const TCHAR* path,	/* Path name of the logical drive number */
+	DWORD len			/* Bytes the next FA_ALIGN file will be extended by */
+)
+{
+	FATFS *fs;
+	FRESULT res;
+	DWORD ncl, ecl, clst, rt[2];
+
+
+	res = find_volume(&fs, &path, 1);
+	if (res != FR_OK) LEAVE_FF(fs, res);
+	if (!fs->au) LEAVE_FF(fs, FR_DENIED);	/* No AU size known */
+
+	len = (len + (DWORD)SS(fs) * fs->csize - 1) / ((DWORD)SS(fs) * fs->csize);	/* Clusters to erase */
+	clst = fs->au_last;
+	while (len) {					/* Same AUs as create_chain_au() takes, one erase per AU */
+		ncl = find_au(fs, clst);
+		if (ncl == 0 && clst) ncl = find_au(fs, 0);	/* Wrap around */
+		if (ncl == 0) break;			/* No AU with a free end left */
+		if (ncl == 1) LEAVE_FF(fs, FR_INT_ERR);
+		if (ncl == 0xFFFFFFFF) LEAVE_FF(fs, FR_DISK_ERR);
+		ecl = ncl + fs->au - (ncl - fs->au0) % fs->au;	/* Boundary after the free end */
+		rt[0] = clust2sect(fs, ncl);
+		rt[1] = clust2sect(fs, ecl - 1) + fs->csize - 1;
+		if (disk_ioctl(fs->drv, CTRL_TRIM, rt) != RES_OK) LEAVE_FF(fs, FR_DENIED);	/* The card cannot erase */
+		len = (ecl - ncl < len) ? len - (ecl - ncl) : 0;
+		clst = (ecl < fs->n_fatent) ? ecl : 0;	/* The chain goes on after this AU */
+	}
+
+	LEAVE_FF(fs, res);
+}
+
+#endif /* !_FS_READONLY && _FS_AUALLOC */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Close File                                                            */
 /*-----------------------------------------------------------------------*/
@@ -2830,8 +3369,13 @@ FRESULT f_close (
 #if _FS_LOCK
 			res = dec_lock(fp->lockid);	/* Decrement file open counter */
 			if (res == FR_OK)
+#endif
+			{
+#if !_FS_TINY && _FS_BUFPOOL
+				return_buf(fp);			/* Buffer is clean after f_sync() */
 #endif
 				fp->fs = 0;				/* Invalidate file object */
+			}
 #if _FS_REENTRANT
 			unlock_fs(fs, FR_OK);		/* Unlock volume */
 #endif
@@ -2843,6 +3387,52 @@ FRESULT f_close (
 
 
 
+#if !_FS_TINY && _FS_BUFPOOL
+/*-----------------------------------------------------------------------*/
+/* Lease or Return the Pool Buffer of a File                             */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_lease (
+	FIL* fp		/* Pointer to the file object to get a buffer */
+)
+{
+	FRESULT res;
+
+
+	res = validate(fp);
+	if (res == FR_OK) {
+		res = lease_buf(fp, 1);			/* Current sector is ready for the next access */
+		if (res != FR_OK) fp->err = (BYTE)res;
+	}
+	LEAVE_FF(fp->fs, res);
+}
+
+
+FRESULT f_release (
+	FIL* fp		/* Pointer to the file object to give back its buffer */
+)
+{
+	FRESULT res;
+
+
+	res = validate(fp);
+	if (res == FR_OK && fp->buf) {
+#if !_FS_READONLY
+		if (fp->flag & FA__DIRTY) {		/* Write-back dirty sector cache */
+			if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
+				LEAVE_FF(fp->fs, FR_DISK_ERR);
+			fp->flag &= ~FA__DIRTY;
+		}
+#endif
+		return_buf(fp);					/* The sector is reloaded on the next access */
+	}
+	LEAVE_FF(fp->fs, res);
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Change Current Directory or Current Drive, Get Current Directory      */
 /*-----------------------------------------------------------------------*/
@@ -3043,6 +3633,10 @@ FRESULT f_lseek (
 							ABORT(fp->fs, FR_DISK_ERR);
 						fp->flag &= ~FA__DIRTY;
 					}
+#endif
+#if _FS_BUFPOOL
+					if (lease_buf(fp, 0) != FR_OK)
+						ABORT(fp->fs, FR_DISK_ERR);
 #endif
 					if (disk_read(fp->fs->drv, fp->buf, dsc, 1) != RES_OK)	/* Load current sector */
 						ABORT(fp->fs, FR_DISK_ERR);
@@ -3075,7 +3669,7 @@ FRESULT f_lseek (
 				clst = fp->sclust;						/* start from the first cluster */
 #if !_FS_READONLY
 				if (clst == 0) {						/* If no cluster chain, create a new chain */
-					clst = create_chain(fp->fs, 0);
+					clst = CREATE_CHAIN(fp, 0);
 					if (clst == 1) ABORT(fp->fs, FR_INT_ERR);
 					if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
 					fp->sclust = clst;
@@ -3087,7 +3681,7 @@ FRESULT f_lseek (
 				while (ofs > bcs) {						/* Cluster following loop */
 #if !_FS_READONLY
 					if (fp->flag & FA_WRITE) {			/* Check if in write mode or not */
-						clst = create_chain(fp->fs, clst);	/* Force stretch if in write mode */
+						clst = CREATE_CHAIN(fp, clst);	/* Force stretch if in write mode */
 						if (clst == 0) {				/* When disk gets full, clip file size */
 							ofs = bcs; break;
 						}
@@ -3116,6 +3710,10 @@ FRESULT f_lseek (
 					ABORT(fp->fs, FR_DISK_ERR);
 				fp->flag &= ~FA__DIRTY;
 			}
+#endif
+#if _FS_BUFPOOL
+			if (lease_buf(fp, 0) != FR_OK)
+				ABORT(fp->fs, FR_DISK_ERR);
 #endif
 			if (disk_read(fp->fs->drv, fp->buf, nsect, 1) != RES_OK)	/* Fill sector cache */
 				ABORT(fp->fs, FR_DISK_ERR);
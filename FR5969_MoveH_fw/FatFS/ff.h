@@ -93,6 +93,11 @@ typedef struct {
 #if !_FS_READONLY
 	DWORD	last_clust;		/* Last allocated cluster */
 	DWORD	free_clust;		/* Number of free clusters */
+#if _FS_AUALLOC
+	DWORD	au;				/* Clusters per allocation unit of the medium (0:no aligned allocation) */
+	DWORD	au0;			/* First cluster on an allocation unit boundary */
+	DWORD	au_last;		/* Last cluster allocated for an FA_ALIGN file */
+#endif
 #endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -132,8 +137,12 @@ typedef struct {
 	UINT	lockid;			/* File lock ID origin from 1 (index of file semaphore table Files[]) */
 #endif
 #if !_FS_TINY
+#if _FS_BUFPOOL
+	BYTE*	buf;			/* Leased data read/write window (0:not held) */
+#else
 	BYTE	buf[_MAX_SS];	/* File private data read/write window */
 #endif
+#endif
 } FIL;
 
 
@@ -240,6 +249,60 @@ FRESULT f_fdisk (BYTE pdrv, const DWORD szt[], void* work);			/* Divide a physic
 int f_putc (TCHAR c, FIL* fp);										/* Put a character to the file */
 int f_puts (const TCHAR* str, FIL* cp);								/* Put a string to the file */
 int f_printf (FIL* fp, const TCHAR* str, ...);						/* Put a formatted string to the file */
+DWORD clust2sect (FATFS* fs, DWORD clst);							/* Get the first sector of a cluster */
+#if !_FS_READONLY && _FS_AUALLOC
+FRESULT f_preerase (const TCHAR* path, DWORD len);					/* Erase the AUs the next FA_ALIGN file will take */
+#endif
+
+#if !_FS_TINY && _FS_BUFPOOL
+FRESULT f_lease (FIL* fp);											/* Hold a pool buffer with the current sector */
+FRESULT f_release (FIL* fp);										/* Write back and return the pool buffer */
+
+extern BYTE FfPool[_FS_BUFPOOL][_MAX_SS];	/* Defined by the application */
+#endif
+
+#if !_FS_READONLY && _FS_WINCACHE
+typedef struct {
+	DWORD	volid;					/* Volume serial number of the cached sectors */
+	DWORD	fatbase;				/* and its FAT start sector (0:card unknown) */
+	DWORD	sect[_FS_WINCACHE];		/* Sector held by each slot (0xFFFFFFFF:empty) */
+	WORD	age[_FS_WINCACHE];		/* Clock at the last use of each slot */
+	WORD	clock;					/* Use counter */
+	BYTE	dirty[_FS_WINCACHE];	/* Slot not written back yet */
+	BYTE	cid[16];				/* Card the cached sectors belong to */
+	BYTE	buf[_FS_WINCACHE][_MAX_SS];	/* Sector data */
+} FFWINCACHE;
+
+FRESULT f_flush (const TCHAR* path);								/* Write back cached FAT and directory sectors */
+
+extern FFWINCACHE FfWinCache;	/* Defined by the application in non-volatile memory */
+#endif
+
+#if !_FS_READONLY && _FS_GEOCACHE
+typedef struct {
+	DWORD	volid;			/* Volume serial number */
+	DWORD	bsect;			/* Volume start sector */
+	DWORD	aus;			/* AU size in sectors (0:no aligned allocation) */
+	DWORD	last_clust;		/* Allocation hints at the last sync */
+	DWORD	au_last;
+	BYTE	cid[16];		/* Card the volume is on */
+	BYTE	valid;			/* Entries describe a mounted volume */
+} FFGEOCACHE;
+
+extern FFGEOCACHE FfGeoCache;	/* Defined by the application in non-volatile memory */
+#endif
+
+#if _FS_STATS
+typedef struct {
+	DWORD	writes;			/* f_write() calls */
+	DWORD	copied;			/* Bytes copied into the file buffer */
+	DWORD	fills;			/* Sectors read into the file buffer before a partial write */
+	DWORD	evicts;			/* Pool buffers taken from another file */
+	DWORD	meta;			/* FAT, directory and FSINFO sectors written */
+} FFSTATS;
+
+extern FFSTATS FfStats;
+#endif
 TCHAR* f_gets (TCHAR* buff, int len, FIL* fp);						/* Get a string from the file */
 
 #define f_eof(fp) ((int)((fp)->fptr == (fp)->fsize))
@@ -301,6 +364,9 @@ int ff_del_syncobj (_SYNC_t sobj);				/* Delete a sync object */
 #define	FA_OPEN_ALWAYS		0x10
 #define FA__WRITTEN			0x20
 #define FA__DIRTY			0x40
+#if _FS_AUALLOC
+#define	FA_ALIGN			0x80
+#endif
 #endif
 
 
@@ -16,6 +16,52 @@
 /  data transfer. */
 
 
+#ifndef _FS_BUFPOOL
+#define	_FS_BUFPOOL		2
+#endif
+/* This option shares _FS_BUFPOOL sector buffers among the file objects instead
+/  of a private buffer in each of them (0:Disable or 1-255:Number of buffers).
+/  A file leases a buffer when it needs one, the least recently used buffer is
+/  written back and taken from its file, which reloads the sector on its next
+/  access. f_release() returns a buffer explicitly. The application defines
+/  BYTE FfPool[_FS_BUFPOOL][_MAX_SS] so that it can place the buffers. Not used
+/  at the tiny configuration. tools/pool_check.c sets it on the command line. */
+
+
+#define	_FS_WINCACHE	4
+/* This option keeps FAT, directory and FSINFO sectors changed in the window in
+/  _FS_WINCACHE cache slots instead of writing them whenever the window moves
+/  or a file is synced (0:Disable or 1-255:Number of slots). Slots are written
+/  back when all of them hold changes and by f_flush(). The application defines
+/  FFWINCACHE FfWinCache in memory that keeps its contents over a reset. The
+/  next mount of the same volume on the same card (disk_ioctl(MMC_GET_CID))
+/  writes the changes still in the cache first, another volume or card
+/  discards them. Not used at the read-only configuration. */
+
+
+#define	_FS_AUALLOC		1
+/* This option places files opened with FA_ALIGN on allocation units (AU) of
+/  the medium, the erase block size from disk_ioctl(GET_BLOCK_SIZE) read at
+/  mount. A new chain and a chain stretched across an AU boundary continue at
+/  the free end of an AU, the first cluster after which the AU is free up to
+/  its boundary, so such a file writes every AU in order up to its end. Other
+/  files do not follow it into these AUs. When no AU has a free end, any free
+/  cluster is taken until the next mount. f_preerase() erases the free ends the
+/  next FA_ALIGN file will take with disk_ioctl(CTRL_TRIM).
+/  (0:Disable or 1:Enable) Not used at the read-only configuration. */
+
+
+#define	_FS_GEOCACHE	1
+/* This option keeps where the volume of the last mounted card starts, the AU
+/  size of the card and the allocation hints of the last sync in FFGEOCACHE
+/  FfGeoCache, defined by the application in memory that keeps its contents
+/  over a reset. A mount of the same card (disk_ioctl(MMC_GET_CID)) and volume
+/  (start sector and serial number) skips disk_ioctl(GET_BLOCK_SIZE) and goes
+/  on allocating where the last mount left off instead of searching the FAT
+/  from its start. The free cluster count is left to FSINFO or f_getfree().
+/  (0:Disable or 1:Enable) Not used at the read-only configuration. */
+
+
 #define _FS_READONLY	0
 /* This option switches read-only configuration. (0:Read/Write or 1:Read-only)
 /  Read-only configuration removes writing API functions, f_write(), f_sync(),
@@ -33,6 +79,13 @@
 /   3: f_lseek() function is removed in addition to 2. */
 
 
+#define	_FS_STATS		1
+/* This option counts f_write() calls, bytes copied through the file buffer,
+/  sectors read to fill it before a partial write, pool buffers taken from
+/  another file and sectors written for FAT, directory and FSINFO in FfStats.
+/  (0:Disable or 1:Enable) */
+
+
 #define	_USE_STRFUNC	1
 /* This option switches string functions, f_gets(), f_putc(), f_puts() and
 /  f_printf().
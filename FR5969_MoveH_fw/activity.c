@@ -0,0 +1,136 @@
+/*
+ * activity.c
+ *
+ *  On-device activity and step summaries, see activity.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "activity.h"
+#include "fixmath.h"
+
+#pragma PERSISTENT(activitySummary)
+bool activitySummary = false;
+#pragma PERSISTENT(activityEpochSeconds)
+uint16_t activityEpochSeconds = 60;
+#pragma PERSISTENT(activityRawSeconds)
+uint16_t activityRawSeconds = 0;
+bool activityEpochReady = false;
+
+static uint16_t mgScale;            // rangeG * 1000, mg = raw * mgScale >> 15
+static uint32_t epochStart;         // ms
+static uint32_t lastTime;           // ms of the previous sample
+static uint32_t enmoSum;            // mg, this epoch
+static uint32_t counts;             // mg*s, this epoch
+static uint16_t samples;            // this epoch
+static uint16_t steps;              // this epoch
+static uint16_t lowPass;            // mg
+static uint32_t lastStep;           // ms
+static bool stepArmed;
+static bool headerDone;
+
+// finished epoch, written by activity_write_epoch
+static uint32_t outTime;
+static uint16_t outEnmo;
+static uint32_t outCounts;
+static uint16_t outSteps;
+
+//*********************************************************************************************
+void activity_set_mode(const char *value){
+    activitySummary = strncmp(value, "summary", 7) == 0;
+}
+//*********************************************************************************************
+void activity_set_epoch(const char *value){
+    uint16_t s = atoi(value);
+
+    if(s){
+        activityEpochSeconds = s;
+    }
+}
+//*********************************************************************************************
+void activity_set_raw(const char *value){
+    activityRawSeconds = atoi(value);
+}
+//*********************************************************************************************
+void activity_start(uint8_t rangeG){
+    mgScale = (uint16_t)rangeG * 1000;
+    epochStart = (uint32_t)activityRawSeconds * 1000;
+    lastTime = epochStart;
+    enmoSum = 0;
+    counts = 0;
+    samples = 0;
+    steps = 0;
+    lowPass = 1000;
+    lastStep = 0;
+    stepArmed = true;
+    headerDone = false;
+    activityEpochReady = false;
+}
+//*********************************************************************************************
+bool activity_raw(uint32_t tMs){
+    return !activitySummary || tMs < (uint32_t)activityRawSeconds * 1000;
+}
+//*********************************************************************************************
+
+static int16_t toMg(int16_t raw){
+    return (int16_t)(((int32_t)raw * mgScale) >> 15);
+}
+//*********************************************************************************************
+void activity_feed(const sample_t *smp){
+    int16_t x, y, z;
+    uint16_t mag, enmo;
+
+    if(!activitySummary || smp->time < epochStart){
+        return;                     // raw window, not summarized
+    }
+
+    x = toMg(smp->xAccel);
+    y = toMg(smp->yAccel);
+    z = toMg(smp->zAccel);
+    mag = isqrt32((int32_t)x * x + (int32_t)y * y + (int32_t)z * z);
+    enmo = mag > 1000 ? mag - 1000 : 0;
+
+    enmoSum += enmo;
+    counts += ((uint32_t)enmo * (uint16_t)(smp->time - lastTime)) / 1000;
+    samples++;
+    lastTime = smp->time;
+
+    // steps: peaks of the magnitude low-passed with alpha = 1/4
+    lowPass += ((int16_t)(mag - lowPass)) >> 2;
+    if(stepArmed){
+        if(lowPass > ACT_STEP_HIGH_MG && smp->time - lastStep >= ACT_STEP_MIN_MS){
+            steps++;
+            lastStep = smp->time;
+            stepArmed = false;
+        }
+    }
+    else if(lowPass < ACT_STEP_LOW_MG){
+        stepArmed = true;
+    }
+
+    if(smp->time - epochStart >= (uint32_t)activityEpochSeconds * 1000){
+        outTime = smp->time / 1000;
+        outEnmo = samples ? enmoSum / samples : 0;
+        outCounts = counts;
+        outSteps = steps;
+        activityEpochReady = true;  // a pending epoch is overwritten if the disk task lags
+
+        epochStart += (uint32_t)activityEpochSeconds * 1000;
+        enmoSum = 0;
+        counts = 0;
+        samples = 0;
+        steps = 0;
+    }
+}
+//*********************************************************************************************
+void activity_write_epoch(FIL *fp){
+    if(!headerDone){
+        f_printf(fp, "%s,%u\n", "epoch_s", activityEpochSeconds);
+        f_printf(fp, "%s,%s,%s,%s\n", "t_s", "enmo_mg", "counts", "steps");
+        headerDone = true;
+    }
+    f_printf(fp, "%lu,%u,%lu,%u\n", outTime, outEnmo, outCounts, outSteps);
+    activityEpochReady = false;
+}
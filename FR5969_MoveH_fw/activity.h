@@ -0,0 +1,40 @@
+/*
+ * activity.h
+ *
+ *  Epoch summaries computed on the device from the accelerometer. Each
+ *  sample gives the vector magnitude in mg (integer square root), ENMO =
+ *  max(|a| - 1 g, 0), an ENMO integral in mg*s as activity count, and a
+ *  step count from peaks of the low-passed magnitude. With log=summary in
+ *  CONFIG.TXT only the first activityRawSeconds of a session are logged raw,
+ *  the epochs go to a summary file next to it, one line each:
+ *
+ *      t_s,enmo_mg,counts,steps
+ */
+
+#ifndef ACTIVITY_H_
+#define ACTIVITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "./FatFS/ff.h"
+#include "channels.h"
+
+#define ACT_STEP_HIGH_MG    1150    // low-passed magnitude above this counts a step ...
+#define ACT_STEP_LOW_MG     1050    // ... and has to drop below this before the next one
+#define ACT_STEP_MIN_MS     250     // shortest step interval, 4 steps/s
+
+extern bool activitySummary;        // FRAM, log=summary
+extern uint16_t activityEpochSeconds;   // FRAM, epoch_s=
+extern uint16_t activityRawSeconds;     // FRAM, raw_s=
+extern bool activityEpochReady;     // epoch complete, to be written by the disk task
+
+void activity_set_mode(const char *value);      // "log=raw|summary"
+void activity_set_epoch(const char *value);     // "epoch_s="
+void activity_set_raw(const char *value);       // "raw_s="
+
+void activity_start(uint8_t rangeG);            // session start, accel full scale in g
+bool activity_raw(uint32_t tMs);                // raw records wanted at session time tMs
+void activity_feed(const sample_t *smp);        // every sample, smp->time in ms
+void activity_write_epoch(FIL *fp);             // writes the header before the first epoch
+
+#endif /* ACTIVITY_H_ */
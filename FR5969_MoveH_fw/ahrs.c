@@ -0,0 +1,174 @@
+/*
+ * ahrs.c
+ *
+ *  Fixed-point Mahony filter, see ahrs.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ahrs.h"
+#include "fixmath.h"
+#include "sched.h"
+
+int16_t ahrsQ[4] = {AHRS_ONE, 0, 0, 0};
+uint32_t ahrsCycles = 0;
+uint32_t ahrsWorst = 0;
+uint64_t ahrsTotal = 0;
+uint32_t ahrsUpdates = 0;
+
+static int32_t q30[4];              // state in Q30, integration steps are far below 1 LSB of Q14
+static uint16_t gyroScale;          // raw -> rad/s Q16, in Q8
+static uint32_t lastTime;           // ms
+static bool first;
+
+//*********************************************************************************************
+// Q14 product
+static int16_t mul(int16_t a, int16_t b){
+    return (int16_t)(((int32_t)a * b) >> 14);
+}
+//*********************************************************************************************
+// scale v to unit length in Q14, false if too short to give a direction
+static bool normalize(int16_t *v){
+    uint32_t sq;
+    uint16_t norm;
+    uint32_t recip;
+    uint8_t i;
+
+    sq = (int32_t)v[0] * v[0];
+    sq += (int32_t)v[1] * v[1];
+    sq += (int32_t)v[2] * v[2];
+    norm = isqrt32(sq);
+    if(norm < 64){
+        return false;
+    }
+    recip = (1UL << 30) / norm;
+    for(i = 0; i < 3; i++){
+        v[i] = (int16_t)(((int32_t)v[i] * (int32_t)recip) >> 16);
+    }
+    return true;
+}
+//*********************************************************************************************
+void ahrs_start(uint16_t gyroRangeDps){
+    // rad/s per LSB in Q16 = range * pi / 180 / 32768 * 65536 = range * 0.0349
+    gyroScale = (uint16_t)(((uint32_t)gyroRangeDps * 2288) >> 8);
+    ahrsQ[0] = AHRS_ONE;
+    ahrsQ[1] = 0;
+    ahrsQ[2] = 0;
+    ahrsQ[3] = 0;
+    q30[0] = 1L << 30;
+    q30[1] = 0;
+    q30[2] = 0;
+    q30[3] = 0;
+    ahrsWorst = 0;
+    ahrsTotal = 0;
+    ahrsUpdates = 0;
+    first = true;
+}
+//*********************************************************************************************
+void ahrs_update(sample_t *smp){
+    int16_t q0 = ahrsQ[0], q1 = ahrsQ[1], q2 = ahrsQ[2], q3 = ahrsQ[3];
+    int16_t a[3], m[3];
+    int16_t vx, vy, vz;
+    int16_t ex = 0, ey = 0, ez = 0;
+    int32_t gx, gy, gz;
+    int16_t hx, hy, hz;
+    int32_t dx, dy, dz;
+    int32_t p0, p1, p2, p3;
+    uint32_t sq;
+    int32_t fix;
+    uint32_t start;
+    uint16_t dt;
+    uint8_t i;
+
+    start = sched_now();
+
+    dt = first ? 0 : (uint16_t)(smp->time - lastTime);
+    if(dt > AHRS_MAX_DT_MS){
+        dt = AHRS_MAX_DT_MS;
+    }
+    lastTime = smp->time;
+    first = false;
+
+    // estimated direction of gravity
+    vx = 2 * (mul(q1, q3) - mul(q0, q2));
+    vy = 2 * (mul(q0, q1) + mul(q2, q3));
+    vz = mul(q0, q0) - mul(q1, q1) - mul(q2, q2) + mul(q3, q3);
+
+    a[0] = smp->xAccel;
+    a[1] = smp->yAccel;
+    a[2] = smp->zAccel;
+    if(normalize(a)){
+        // error = measured x estimated
+        ex = mul(a[1], vz) - mul(a[2], vy);
+        ey = mul(a[2], vx) - mul(a[0], vz);
+        ez = mul(a[0], vy) - mul(a[1], vx);
+
+        // AK09916 axes in the accel frame: x, -y, -z
+        m[0] = smp->xMag;
+        m[1] = -smp->yMag;
+        m[2] = -smp->zMag;
+        if(normalize(m)){
+            int16_t q1q1 = mul(q1, q1), q2q2 = mul(q2, q2), q3q3 = mul(q3, q3);
+            int16_t q0q1 = mul(q0, q1), q0q2 = mul(q0, q2), q0q3 = mul(q0, q3);
+            int16_t q1q2 = mul(q1, q2), q1q3 = mul(q1, q3), q2q3 = mul(q2, q3);
+            int16_t bx, bz, wx, wy, wz;
+            int16_t half = AHRS_ONE / 2;
+
+            // reference direction of the earth field
+            hx = 2 * (mul(m[0], half - q2q2 - q3q3) + mul(m[1], q1q2 - q0q3) + mul(m[2], q1q3 + q0q2));
+            hy = 2 * (mul(m[0], q1q2 + q0q3) + mul(m[1], half - q1q1 - q3q3) + mul(m[2], q2q3 - q0q1));
+            hz = 2 * (mul(m[0], q1q3 - q0q2) + mul(m[1], q2q3 + q0q1) + mul(m[2], half - q1q1 - q2q2));
+            bx = isqrt32((int32_t)hx * hx + (int32_t)hy * hy);
+            bz = hz;
+
+            // estimated direction of the field
+            wx = 2 * (mul(bx, half - q2q2 - q3q3) + mul(bz, q1q3 - q0q2));
+            wy = 2 * (mul(bx, q1q2 - q0q3) + mul(bz, q0q1 + q2q3));
+            wz = 2 * (mul(bx, q0q2 + q1q3) + mul(bz, half - q1q1 - q2q2));
+
+            ex += mul(m[1], wz) - mul(m[2], wy);
+            ey += mul(m[2], wx) - mul(m[0], wz);
+            ez += mul(m[0], wy) - mul(m[1], wx);
+        }
+    }
+
+    // corrected rates, rad/s Q16
+    gx = (((int32_t)smp->xGyro * gyroScale) >> 8) + (((int32_t)ex * AHRS_KP_Q8) >> 6);
+    gy = (((int32_t)smp->yGyro * gyroScale) >> 8) + (((int32_t)ey * AHRS_KP_Q8) >> 6);
+    gz = (((int32_t)smp->zGyro * gyroScale) >> 8) + (((int32_t)ez * AHRS_KP_Q8) >> 6);
+
+    // half angle in Q24: rate * dt / 2 / 1000 * 256 = rate * dt * 131 / 2^10
+    dx = (((gx * dt) >> 3) * 131) >> 7;
+    dy = (((gy * dt) >> 3) * 131) >> 7;
+    dz = (((gz * dt) >> 3) * 131) >> 7;
+
+    // q += q * (0, d), 32x32 bit products on the MPY32
+    p0 = q30[0];
+    p1 = q30[1];
+    p2 = q30[2];
+    p3 = q30[3];
+    q30[0] = p0 - (int32_t)(((int64_t)p1 * dx + (int64_t)p2 * dy + (int64_t)p3 * dz) >> 24);
+    q30[1] = p1 + (int32_t)(((int64_t)p0 * dx + (int64_t)p2 * dz - (int64_t)p3 * dy) >> 24);
+    q30[2] = p2 + (int32_t)(((int64_t)p0 * dy - (int64_t)p1 * dz + (int64_t)p3 * dx) >> 24);
+    q30[3] = p3 + (int32_t)(((int64_t)p0 * dz + (int64_t)p1 * dy - (int64_t)p2 * dx) >> 24);
+
+    // back to unit length with one Newton step of 1/sqrt: q *= (3 - |q|^2) / 2
+    sq = 0;
+    for(i = 0; i < 4; i++){
+        ahrsQ[i] = (int16_t)((q30[i] + (1L << 15)) >> 16);
+        sq += (int32_t)ahrsQ[i] * ahrsQ[i];                 // Q28
+    }
+    fix = (int32_t)((3UL << 28) - sq) >> 1;                 // Q28
+    for(i = 0; i < 4; i++){
+        q30[i] = (int32_t)(((int64_t)q30[i] * fix) >> 28);
+        ahrsQ[i] = (int16_t)((q30[i] + (1L << 15)) >> 16);
+        smp->q[i] = ahrsQ[i];
+    }
+
+    ahrsCycles = (sched_now() - start) * 8;         // Timer0_B runs at MCLK / 8
+    ahrsTotal += ahrsCycles;
+    ahrsUpdates++;
+    if(ahrsCycles > ahrsWorst){
+        ahrsWorst = ahrsCycles;
+    }
+}
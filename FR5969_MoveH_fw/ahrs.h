@@ -0,0 +1,32 @@
+/*
+ * ahrs.h
+ *
+ *  Orientation quaternion from accel, gyro and magnetometer with a Mahony
+ *  complementary filter in fixed point. Correction terms use Q14 (16384 =
+ *  1.0) and 16x16 bit products, rates are rad/s in Q16, and the quaternion
+ *  is integrated in Q30 with 32x32 bit products, all on the MPY32. It is
+ *  logged as Q14 with the 'q' channel, see channels.h. Every update is
+ *  timed with sched_now(); the times are in MCLK cycles, with the 8 cycle
+ *  resolution of Timer0_B.
+ */
+
+#ifndef AHRS_H_
+#define AHRS_H_
+
+#include <stdint.h>
+#include "channels.h"
+
+#define AHRS_ONE            16384   // 1.0 in Q14
+#define AHRS_KP_Q8          512     // proportional gain 2.0 in Q8
+#define AHRS_MAX_DT_MS      50      // longer gaps are clipped, e.g. after a card stall
+
+extern int16_t ahrsQ[4];            // w, x, y, z in Q14
+extern uint32_t ahrsCycles;         // duration of the last update
+extern uint32_t ahrsWorst;          // longest update since ahrs_start
+extern uint64_t ahrsTotal;          // all updates since ahrs_start
+extern uint32_t ahrsUpdates;        // number of updates since ahrs_start
+
+void ahrs_start(uint16_t gyroRangeDps);         // session start, resets to identity
+void ahrs_update(sample_t *smp);                // every sample, fills smp->q
+
+#endif /* AHRS_H_ */
@@ -0,0 +1,178 @@
+/*
+ * ak09916.c
+ *
+ *  Non-blocking AK09916 bring-up, see ak09916.h.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include "ak09916.h"
+#include "icm20948.h"
+#include "sched.h"
+#include "main.h"
+
+#define AK_WIA2_ID          0x09
+
+// I2C_MST_STATUS
+#define MST_SLV4_DONE       0x40
+#define MST_SLV4_NACK       0x10
+
+// bring-up steps
+#define STEP_IDLE           0
+#define STEP_ID             1       // waiting for the WIA2 read
+#define STEP_MODE           2       // waiting for the CNTL2 write
+#define STEP_RESET          3       // I2C master reset settling
+
+ak_health_t akHealth = AK_HEALTH_UNKNOWN;
+uint8_t akTries = 0;
+
+static uint8_t step = STEP_IDLE;
+static uint8_t ticksLeft = 0;
+static ak_health_t failure = AK_HEALTH_NO_RESPONSE;    // reported if the last try fails
+
+//*********************************************************************************************
+//for readMag: addr=0x80 | address
+//for writeMag:addr=0x00 | address
+
+// SLV4 single read of WIA2
+static const icm_reg_t idTable[] = {
+    {3, ICM_I2C_SLV4_ADDR,  0b10001100, 0xFF, 0, ICM_SRC_CONST},  // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW
+    {3, ICM_I2C_SLV4_REG,   0b00000001, 0xFF, 0, ICM_SRC_CONST},  // BIT[7:0] to register address 0x01 WIA2
+    {3, ICM_I2C_SLV4_CTRL,  0b10000000, 0xFF, 0, ICM_SRC_CONST},  // EN bit enable, rest disabled
+};
+
+// SLV4 write of CNTL2, mode 4: 100Hz continuous measurement
+static const icm_reg_t modeTable[] = {
+    {3, ICM_I2C_SLV4_DO,    0b00001000, 0xFF, 0, ICM_SRC_CONST},  // BIT[7:0] to mode 4: 100Hz continuous measurement
+    {3, ICM_I2C_SLV4_ADDR,  0b00001100, 0xFF, 0, ICM_SRC_CONST},  // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW
+    {3, ICM_I2C_SLV4_REG,   0b00110001, 0xFF, 0, ICM_SRC_CONST},  // BIT[7:0] to register address 0x31 -->AK09916_REG_CNTL2
+    {3, ICM_I2C_SLV4_CTRL,  0b10000000, 0xFF, 0, ICM_SRC_CONST},  // EN bit enable, rest disabled
+};
+
+// SLV0 reads ST1..ST2 into EXT_SLV_SENS_DATA with every sample
+static const icm_reg_t slave0Table[] = {
+    {3, ICM_I2C_SLV0_ADDR,  0b10001100, 0xFF, 0, ICM_SRC_CONST},  // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW(read mode)
+    {3, ICM_I2C_SLV0_REG,   0b00010000, 0xFF, 0, ICM_SRC_CONST},  // BIT[7:0] to register address 0x10 -->AK09916_REG_ST1
+    {3, ICM_I2C_SLV0_CTRL,  0b10001001, 0xFF, 0, ICM_SRC_CONST},  // BITS[3:0] for number of transmitted bytes(9),BIT[7] enable reading
+};
+
+// I2C master reset, settling is counted in ticks
+static const icm_reg_t resetTable[] = {
+    {0, ICM_USER_CTRL,      0b00000010, 0x02, 0, ICM_SRC_CONST},  // BIT[1]: I2C_MST_RST
+};
+
+static const icm_reg_t enableTable[] = {
+    {0, ICM_USER_CTRL,      0b00100000, 0x20, 0, ICM_SRC_CONST},  // set BIT[5] to enable I2C master
+};
+
+//*********************************************************************************************
+static void finish(ak_health_t health){
+    TA3CTL = MC__STOP;
+    TA3CCTL0 = 0;
+    step = STEP_IDLE;
+    akHealth = health;
+}
+//*********************************************************************************************
+static void tryId(void){
+    akTries++;
+    icm_apply(idTable, ICM_TABLE_LEN(idTable));
+    step = STEP_ID;
+    ticksLeft = AK_TIMEOUT_TICKS;
+}
+//*********************************************************************************************
+static void retry(void){
+    if(akTries >= AK_TRIES){
+        finish(failure);
+        return;
+    }
+    icm_apply(resetTable, ICM_TABLE_LEN(resetTable));
+    step = STEP_RESET;
+    ticksLeft = AK_RESET_TICKS;
+}
+//*********************************************************************************************
+void ak_start(void){
+    akHealth = AK_HEALTH_STARTING;
+    akTries = 0;
+    failure = AK_HEALTH_NO_RESPONSE;
+    tryId();
+
+    // Timer3_A: ~1 ms tick from ACLK paces the status checks
+    TA3CCR0 = 33 - 1;
+    TA3CCTL0 = CCIE;
+    TA3CTL = TASSEL__ACLK | MC__UP | TACLR;
+}
+//*********************************************************************************************
+void ak_poll(void){
+    uint8_t status;
+
+    switch(step){
+        case STEP_RESET:
+            if(--ticksLeft == 0){
+                icm_apply(enableTable, ICM_TABLE_LEN(enableTable));
+                tryId();
+            }
+            break;
+
+        case STEP_ID:
+        case STEP_MODE:
+            status = icm_read(0, ICM_I2C_MST_STATUS);   // clears on read
+            if(status & MST_SLV4_NACK){
+                failure = AK_HEALTH_NO_RESPONSE;
+                retry();
+            }
+            else if(status & MST_SLV4_DONE){
+                if(step == STEP_MODE){
+                    icm_apply(slave0Table, ICM_TABLE_LEN(slave0Table));
+                    finish(AK_HEALTH_OK);
+                }
+                else if(icm_read(3, ICM_I2C_SLV4_DI) == AK_WIA2_ID){
+                    icm_apply(modeTable, ICM_TABLE_LEN(modeTable));
+                    step = STEP_MODE;
+                    ticksLeft = AK_TIMEOUT_TICKS;
+                }
+                else{
+                    failure = AK_HEALTH_BAD_ID;
+                    retry();
+                }
+            }
+            else if(--ticksLeft == 0){
+                failure = AK_HEALTH_NO_RESPONSE;
+                retry();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+//*********************************************************************************************
+// The rest of the bring-up in the foreground, at most AK_TRIES times the
+// reset and transfer budget. Ticks posted meanwhile find the step idle.
+void ak_finish(void){
+    while(akHealth == AK_HEALTH_STARTING){
+        __delay_cycles(MCLK_FREQUENCY / 1000);     // one Timer3_A tick
+        ak_poll();
+    }
+}
+//*********************************************************************************************
+const char *ak_health_name(void){
+    switch(akHealth){
+        case AK_HEALTH_OK:
+            return "ok";
+        case AK_HEALTH_STARTING:
+            return "starting";
+        case AK_HEALTH_NO_RESPONSE:
+            return "no response";
+        case AK_HEALTH_BAD_ID:
+            return "bad id";
+        default:
+            return "unknown";
+    }
+}
+//*********************************************************************************************
+
+#pragma vector = TIMER3_A0_VECTOR
+__interrupt void TIMER3_A0_ISR(void){
+    sched_post(EVT_MAG_TICK);
+    __bic_SR_register_on_exit(LPM3_bits);
+}
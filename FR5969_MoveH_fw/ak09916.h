@@ -0,0 +1,39 @@
+/*
+ * ak09916.h
+ *
+ *  AK09916 magnetometer behind the I2C master of the ICM20948. Bring-up runs
+ *  in the background: every SLV4 transfer is started and then checked once
+ *  per Timer3_A tick (EVT_MAG_TICK) instead of busy polling, each step has a
+ *  tick budget, and a failed attempt resets the I2C master and retries up to
+ *  AK_TRIES times. The outcome is reported in akHealth; a missing or wrong
+ *  device leaves the logger running with zero magnetometer columns. A
+ *  session start does not wait for the tick: ak_finish() completes a
+ *  bring-up still in progress, so a session never runs with it pending.
+ */
+
+#ifndef AK09916_H_
+#define AK09916_H_
+
+#include <stdint.h>
+
+#define AK_TRIES            5       // bring-up attempts
+#define AK_TIMEOUT_TICKS    10      // ms for one SLV4 transfer
+#define AK_RESET_TICKS      10      // ms after I2C_MST_RST
+
+typedef enum {
+    AK_HEALTH_UNKNOWN,              // ak_start() not called yet
+    AK_HEALTH_STARTING,             // bring-up in progress
+    AK_HEALTH_OK,                   // 100 Hz continuous mode, read by SLV0
+    AK_HEALTH_NO_RESPONSE,          // NACK or no SLV4_DONE on every try
+    AK_HEALTH_BAD_ID                // answered, but WIA2 is not 0x09
+} ak_health_t;
+
+extern ak_health_t akHealth;
+extern uint8_t akTries;             // attempts used by the last bring-up
+
+void ak_start(void);                // after the ICM20948 init table, needs the scheduler
+void ak_poll(void);                 // EVT_MAG_TICK handler
+void ak_finish(void);               // before a session, blocks until akHealth is final
+const char *ak_health_name(void);   // short text for the file header
+
+#endif /* AK09916_H_ */
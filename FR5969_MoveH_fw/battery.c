@@ -0,0 +1,137 @@
+/*
+ * battery.c
+ *
+ *  Supply voltage monitoring, see battery.h.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "battery.h"
+#include "sched.h"
+
+volatile uint16_t batteryMilliVolts = 0;
+volatile bool batteryLow = false;
+
+// Voltage history of the running session. When it fills up, neighbouring
+// entries are averaged and the period doubles, so a session of any length fits.
+#pragma PERSISTENT(batteryLog)
+uint16_t batteryLog[BATTERY_LOG_LEN] = {0};
+static volatile uint16_t logCount = 0;
+static volatile uint16_t logPeriod = BATTERY_LOG_PERIOD;
+static volatile uint16_t logTick = 0;
+static volatile bool logging = false;
+static volatile uint32_t uptimeSeconds = 0;
+
+//*********************************************************************************************
+void battery_init(void){
+    // Timer2_A: 1 Hz tick from ACLK (LFXT 32768 Hz) starts a conversion
+    TA2CCR0 = 32768 - 1;
+    TA2CCTL0 = CCIE;
+    TA2CTL = TASSEL__ACLK | MC__UP | TACLR;
+
+    // ADC12_B: single conversion of AVCC/2 (A31 with BATMAP) against 2.0 V VREF
+    ADC12CTL0 = ADC12SHT0_10 | ADC12ON;         // 512 cycle sample time, covers REF settling
+    ADC12CTL1 = ADC12SHP;                       // sample timer
+    ADC12CTL2 = ADC12RES_2;                     // 12 bit
+    ADC12CTL3 = ADC12BATMAP;                    // AVCC/2 on channel 31
+    ADC12MCTL0 = ADC12INCH_31 | ADC12VRSEL_1;   // VR+ = VREF buffered, VR- = AVSS
+    ADC12IER0 = ADC12IE0;
+}
+//*********************************************************************************************
+uint32_t clock_ms(void){
+    uint32_t sec;
+    uint16_t sub, check;
+    uint16_t gie = __get_SR_register() & GIE;
+
+    __disable_interrupt();
+    do{                                         // TA2R counts on ACLK, read until stable
+        sub = TA2R;
+        check = TA2R;
+    } while(sub != check);
+    sec = uptimeSeconds;
+    if(TA2CCTL0 & CCIFG){                       // wrap not yet serviced
+        sec++;
+        sub = 0;
+    }
+    __bis_SR_register(gie);
+    return sec * 1000 + (uint16_t)(((uint32_t)sub * 1000) >> 15);
+}
+//*********************************************************************************************
+void battery_log_start(void){
+    logCount = 0;
+    logPeriod = BATTERY_LOG_PERIOD;
+    logTick = 0;
+    logging = true;
+}
+//*********************************************************************************************
+static void logAppend(uint16_t mv){
+    uint16_t i;
+
+    if(++logTick < logPeriod){
+        return;
+    }
+    logTick = 0;
+    if(logCount == BATTERY_LOG_LEN){
+        for(i = 0; i < BATTERY_LOG_LEN / 2; i++){
+            batteryLog[i] = (batteryLog[2 * i] + batteryLog[2 * i + 1]) >> 1;
+        }
+        logCount = BATTERY_LOG_LEN / 2;
+        logPeriod <<= 1;
+    }
+    batteryLog[logCount++] = mv;
+}
+//*********************************************************************************************
+// write the voltage history of the session as "t_s,vcc_mV" lines to name
+FRESULT battery_log_write(FIL *fp, const char *name){
+    FRESULT fr;
+    uint16_t i;
+
+    logging = false;
+    fr = f_open(fp, name, FA_WRITE | FA_CREATE_ALWAYS);
+    if(fr != FR_OK){
+        return fr;
+    }
+    f_printf(fp, "%s,%s\n", "t_s", "vcc_mV");
+    for(i = 0; i < logCount; i++){
+        f_printf(fp, "%lu,%u\n", (uint32_t)(i + 1) * logPeriod, batteryLog[i]);
+    }
+    return f_close(fp);
+}
+//*********************************************************************************************
+
+#pragma vector = TIMER2_A0_VECTOR
+__interrupt void TIMER2_A0_ISR(void){
+    uptimeSeconds++;
+    REFCTL0 |= REFVSEL_1 | REFON;               // 2.0 V reference, off again after conversion
+    ADC12CTL0 |= ADC12ENC | ADC12SC;
+    sched_post(EVT_RTC_TICK);
+    __bic_SR_register_on_exit(LPM3_bits);
+}
+//*********************************************************************************************
+
+#pragma vector = ADC12_VECTOR
+__interrupt void ADC12_ISR(void){
+    switch(__even_in_range(ADC12IV, ADC12IV__ADC12RDYIFG)){
+        case ADC12IV__ADC12IFG0:
+            // VCC = 2 * ADC * 2000 mV / 4096
+            batteryMilliVolts = (uint16_t)(((uint32_t)ADC12MEM0 * 4000) >> 12);
+            ADC12CTL0 &= ~ADC12ENC;
+            REFCTL0 &= ~REFON;
+
+            if(logging){
+                logAppend(batteryMilliVolts);
+            }
+            if(!batteryLow && batteryMilliVolts < BATTERY_LOW_MV){
+                batteryLow = true;
+                sched_post(EVT_LOW_BATTERY);            // let the main loop close the session
+                __bic_SR_register_on_exit(LPM3_bits);
+            }
+            else if(batteryLow && batteryMilliVolts > BATTERY_OK_MV){
+                batteryLow = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
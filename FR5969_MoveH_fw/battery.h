@@ -0,0 +1,31 @@
+/*
+ * battery.h
+ *
+ *  Supply voltage monitoring with ADC12_B. AVCC/2 is converted once per
+ *  second against the internal 2.0 V reference (Timer2_A, ACLK). Readings
+ *  below BATTERY_LOW_MV set batteryLow and post EVT_LOW_BATTERY so the open
+ *  session can be closed while the card still works. Every tick also posts
+ *  EVT_RTC_TICK and advances the uptime clock read by clock_ms().
+ */
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "./FatFS/ff.h"
+
+#define BATTERY_LOW_MV      2900        // below this SD writes get unreliable
+#define BATTERY_OK_MV       3000        // hysteresis: recording is allowed again above this
+#define BATTERY_LOG_LEN     128         // entries in the FRAM voltage history
+#define BATTERY_LOG_PERIOD  10          // initial seconds between history entries
+
+extern volatile uint16_t batteryMilliVolts;     // last reading
+extern volatile bool batteryLow;                // set by ADC ISR, cleared above BATTERY_OK_MV
+
+void battery_init(void);
+uint32_t clock_ms(void);                        // ms since battery_init, 1/32768 s resolution
+void battery_log_start(void);                   // at session start
+FRESULT battery_log_write(FIL *fp, const char *name);   // at session end, fp must be closed
+
+#endif /* BATTERY_H_ */
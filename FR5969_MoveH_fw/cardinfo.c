@@ -0,0 +1,136 @@
+/*
+ * cardinfo.c
+ *
+ *  Write profile of the SD card, see cardinfo.h.
+ *
+ *  The writes go to the sectors of CARDINFO.TXT, sized for all runs before
+ *  the first one, through MMC_WRITE_TEST: every sector of a run gets the same
+ *  512 bytes, so no buffer of more than one sector is needed. Each write is
+ *  timed up to the end of its busy phase. The file holds the report after
+ *  the runs, the test data is truncated away.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "cardinfo.h"
+#include "./FatFS/diskio.h"
+#include "main.h"
+#include "logbuf.h"
+#include "sdcard.h"
+#include "sched.h"
+
+#define TICKS_PER_MS        (SMCLK_FREQUENCY / 8000)    // Timer0_B runs on SMCLK / 8
+#define SIZE_BETTER(a, b)   ((a) && (a) < (b) - (b) / 8)    // a bigger block has to save 1/8
+
+#pragma PERSISTENT(cardInfo)
+cardinfo_t cardInfo = {{0}, {0, 0, 0}, 0, 1, 0};
+
+//*********************************************************************************************
+static uint16_t busyMs(void){
+    uint32_t ms = (uint32_t)cardInfo.worstMs * CARDINFO_BUSY_X;
+
+    return (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+}
+
+static void apply(void){
+    logbuf_set_sectors(cardInfo.sectors);
+    sd_set_card_busy(busyMs());
+}
+//*********************************************************************************************
+// CARDINFO_RUNS writes of n sectors from file offset ofs on. n divides the
+// cluster size and ofs, so a run never leaves its cluster. Returns the time
+// per sector in us, 0 on an error; the longest write goes to *worst.
+static uint16_t timeWrites(FIL *fp, DWORD *arg, DWORD ofs, uint8_t n, uint32_t *worst){
+    FATFS *fs = fp->fs;
+    DWORD bcs = (DWORD)fs->csize * _MAX_SS;
+    uint32_t t, total = 0;
+    uint8_t i;
+
+    for(i = 0; i < CARDINFO_RUNS; i++, ofs += (DWORD)n * _MAX_SS){
+        if(f_lseek(fp, ofs - ofs % bcs + bcs) != FR_OK){    // end of the cluster of ofs, no sector read
+            return 0;
+        }
+        arg[0] = clust2sect(fs, fp->clust) + (ofs % bcs) / _MAX_SS;
+        arg[1] = n;
+        t = sched_now();
+        if(disk_ioctl(fs->drv, MMC_WRITE_TEST, arg) != RES_OK || disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK){
+            return 0;
+        }
+        t = sched_now() - t;
+        total += t;
+        if(t > *worst){
+            *worst = t;
+        }
+    }
+    total = total / ((uint32_t)CARDINFO_RUNS * n) * 1000 / TICKS_PER_MS;
+    return (total > 0xFFFF) ? 0xFFFF : (total ? (uint16_t)total : 1);
+}
+//*********************************************************************************************
+// The pool buffers are free at boot: FfPool[0] carries the runs, FfPool[1] the
+// CID until the report is written through the pool.
+FRESULT cardinfo_check(FATFS *fs, FIL *fp){
+    DWORD *arg = (DWORD *)FfPool[0];
+    BYTE *cid = FfPool[1];
+    DWORD size = (DWORD)CARDINFO_RUNS * ((1 << CARDINFO_SIZES) - 1) * _MAX_SS;
+    DWORD ofs = 0;
+    uint32_t worst = 0;
+    uint8_t i, n;
+    FRESULT fr;
+
+    if(disk_ioctl(fs->drv, MMC_GET_CID, cid) != RES_OK){
+        return FR_DISK_ERR;
+    }
+    if(memcmp(cid, cardInfo.cid, sizeof(cardInfo.cid)) == 0){
+        apply();                                // known card
+        return FR_OK;
+    }
+    memset(cardInfo.cid, 0, sizeof(cardInfo.cid));  // measured again after a reset in between
+
+    fr = f_open(fp, CARDINFO_FILE, FA_WRITE | FA_CREATE_ALWAYS);
+    if(fr != FR_OK){
+        return fr;
+    }
+    fr = f_lseek(fp, size);                     // allocates the clusters for all runs
+    if(fr == FR_OK && fp->fptr != size){
+        fr = FR_DENIED;                         // card full
+    }
+    for(i = 0, n = 1; fr == FR_OK && i < CARDINFO_SIZES; i++, n <<= 1){
+        cardInfo.usPerSector[i] = 0;
+        if(n <= fs->csize){                     // runs over a cluster end are not timed
+            cardInfo.usPerSector[i] = timeWrites(fp, arg, ofs, n, &worst);
+            if(!cardInfo.usPerSector[i]){
+                fr = FR_DISK_ERR;
+            }
+        }
+        ofs += (DWORD)CARDINFO_RUNS * n * _MAX_SS;
+    }
+
+    if(fr == FR_OK){
+        cardInfo.worstMs = (uint16_t)((worst + TICKS_PER_MS - 1) / TICKS_PER_MS);
+        n = 0;
+        for(i = 1; i < CARDINFO_SIZES; i++){
+            if(SIZE_BETTER(cardInfo.usPerSector[i], cardInfo.usPerSector[n])){
+                n = i;
+            }
+        }
+        cardInfo.sectors = (uint8_t)(1 << n);
+        memcpy(cardInfo.cid, cid, sizeof(cardInfo.cid));    // profile complete
+
+        fr = f_lseek(fp, 0);
+        if(fr == FR_OK){
+            fr = f_truncate(fp);
+        }
+        f_printf(fp, "%s", "cid,");
+        for(i = 0; i < sizeof(cardInfo.cid); i++){
+            f_printf(fp, "%02X", cardInfo.cid[i]);
+        }
+        f_printf(fp, "\n%s,%u,%u,%u,%s\n", "write", cardInfo.usPerSector[0], cardInfo.usPerSector[1], cardInfo.usPerSector[2], "us_per_sector");
+        f_printf(fp, "%s,%u,%s\n", "worst", cardInfo.worstMs, "ms");
+        f_printf(fp, "%s,%u,%s,%u,%s\n", "block", cardInfo.sectors, "sectors", busyMs(), "ms_busy");
+        apply();
+    }
+    if(f_close(fp) != FR_OK && fr == FR_OK){
+        fr = FR_DISK_ERR;                       // report lost, the profile is kept
+    }
+    return fr;
+}
@@ -0,0 +1,35 @@
+/*
+ * cardinfo.h
+ *
+ *  Write profile of the SD card. The first time a card is mounted, told
+ *  apart by its CID, cardinfo_check() times writes of 1, 2 and 4 sectors
+ *  into the clusters of CARDINFO.TXT, keeps the result in FRAM and leaves it
+ *  in that file as text. The profile picks the logbuf block size with the
+ *  cheapest write per sector and raises the busy timeout to a multiple of
+ *  the longest write seen. A card measured before is not written to again.
+ */
+
+#ifndef CARDINFO_H_
+#define CARDINFO_H_
+
+#include <stdint.h>
+#include "./FatFS/ff.h"
+
+#define CARDINFO_FILE       "CARDINFO.TXT"
+#define CARDINFO_RUNS       8       // timed writes per block size
+#define CARDINFO_SIZES      3       // block sizes 1, 2 and 4 sectors
+#define CARDINFO_BUSY_X     4       // busy timeout floor in longest writes
+
+typedef struct {
+    uint8_t  cid[16];               // card the profile belongs to
+    uint16_t usPerSector[CARDINFO_SIZES];   // by block size, busy time included, 0 = not measured
+    uint16_t worstMs;               // longest write, busy time included
+    uint8_t  sectors;               // logbuf block size chosen
+    uint8_t  pad;
+} cardinfo_t;
+
+extern cardinfo_t cardInfo;         // FRAM, profile of the last card measured
+
+FRESULT cardinfo_check(FATFS *fs, FIL *fp);     // at boot, after sdBenchmark(), fp must be closed
+
+#endif /* CARDINFO_H_ */
@@ -0,0 +1,202 @@
+/*
+ * channels.c
+ *
+ *  Selectable log channels, see channels.h.
+ */
+
+#include <stdint.h>
+#include "channels.h"
+#include "icm20948.h"
+#include "logbuf.h"
+
+// register blocks from ACCEL_XOUT_H, in burst order
+#define OFS_ACCEL           0       // ACCEL_XOUT_H..ACCEL_ZOUT_L
+#define OFS_GYRO            6       // GYRO_XOUT_H..GYRO_ZOUT_L
+#define OFS_TEMP            12      // TEMP_OUT_H, TEMP_OUT_L
+#define OFS_MAG             14      // EXT_SLV_SENS_DATA_00..08: ST1, HXL..HZH, TMPS, ST2
+#define OFS_END             23
+
+#pragma PERSISTENT(channelMask)
+uint8_t channelMask = CH_DEFAULT;
+uint8_t channelBurstReg = ICM_ACCEL_XOUT_H;
+uint8_t channelBurstLen = OFS_END;
+
+static uint8_t readMask = CH_DEFAULT;   // channelMask plus channels needed on the device
+static uint8_t burstStart = 0;      // offset of channelBurstReg from ACCEL_XOUT_H
+static int16_t xMag = 0;            // last valid magnetometer reading, kept on overflow
+static int16_t yMag = 0;
+static int16_t zMag = 0;
+
+//*********************************************************************************************
+void channels_set(const char *value){
+    uint8_t mask = 0;
+
+    for(; *value; value++){
+        switch(*value){
+            case 'a': mask |= CH_ACCEL; break;
+            case 'g': mask |= CH_GYRO;  break;
+            case 't': mask |= CH_TEMP;  break;
+            case 'm': mask |= CH_MAG;   break;
+            case 's': mask |= CH_TIME;  break;
+            case 'q': mask |= CH_QUAT;  break;
+            default: break;             // line end
+        }
+    }
+    if(mask){
+        channelMask = mask;
+    }
+}
+//*********************************************************************************************
+void channels_layout(uint8_t extra){
+    uint8_t first = OFS_END;
+    uint8_t last = 0;
+
+    readMask = channelMask | extra;
+    if(readMask & CH_QUAT){
+        readMask |= CH_ACCEL | CH_GYRO | CH_MAG;
+    }
+
+    if(readMask & CH_ACCEL){
+        first = OFS_ACCEL;
+        last = OFS_GYRO;
+    }
+    if(readMask & CH_GYRO){
+        if(first > OFS_GYRO) first = OFS_GYRO;
+        last = OFS_TEMP;
+    }
+    if(readMask & CH_TEMP){
+        if(first > OFS_TEMP) first = OFS_TEMP;
+        last = OFS_MAG;
+    }
+    if(readMask & CH_MAG){
+        if(first > OFS_MAG) first = OFS_MAG;
+        last = OFS_END;
+    }
+
+    if(last == 0){
+        burstStart = 0;
+        channelBurstLen = 0;
+    }
+    else{
+        burstStart = first;
+        channelBurstLen = last - first;
+    }
+    channelBurstReg = ICM_ACCEL_XOUT_H + burstStart;
+}
+//*********************************************************************************************
+// RX_Data holds the burst in reverse order, first byte in RX_Data[channelBurstLen-1]
+static uint8_t rx(uint8_t ofs){
+    return RX_Data[channelBurstLen - 1 - (ofs - burstStart)];
+}
+
+static int16_t rxBig(uint8_t ofs){
+    return (int16_t)((rx(ofs) << 8) | rx(ofs + 1));
+}
+
+static int16_t rxLittle(uint8_t ofs){
+    return (int16_t)(rx(ofs) | (rx(ofs + 1) << 8));
+}
+//*********************************************************************************************
+void channels_parse(sample_t *smp, uint32_t time){
+    smp->time = time;
+    if(readMask & CH_ACCEL){
+        smp->xAccel = rxBig(OFS_ACCEL);
+        smp->yAccel = rxBig(OFS_ACCEL + 2);
+        smp->zAccel = rxBig(OFS_ACCEL + 4);
+    }
+    if(readMask & CH_GYRO){
+        smp->xGyro = rxBig(OFS_GYRO);
+        smp->yGyro = rxBig(OFS_GYRO + 2);
+        smp->zGyro = rxBig(OFS_GYRO + 4);
+    }
+    if(readMask & CH_TEMP){
+        smp->temp = rxBig(OFS_TEMP);
+    }
+    if(readMask & CH_MAG){
+        if(!(rx(OFS_MAG + 8) & (1<<3))){        // ST2 HOFL: keep the last reading
+            xMag = rxLittle(OFS_MAG + 1);        // magnetometer puts data out in little endian
+            yMag = rxLittle(OFS_MAG + 3);
+            zMag = rxLittle(OFS_MAG + 5);
+        }
+        smp->xMag = xMag;
+        smp->yMag = yMag;
+        smp->zMag = zMag;
+    }
+}
+//*********************************************************************************************
+void channels_write_header(FIL *fp){
+    const char *sep = "";
+
+    if(channelMask & CH_TIME){
+        logbuf_printf(fp, "%s", "t_ms");
+        sep = ",";
+    }
+    if(channelMask & CH_ACCEL){
+        logbuf_printf(fp, "%s%s,%s,%s", sep, "xAccel","yAccel","zAccel");
+        sep = ",";
+    }
+    if(channelMask & CH_GYRO){
+        logbuf_printf(fp, "%s%s,%s,%s", sep, "xGyro","yGyro","zGyro");
+        sep = ",";
+    }
+    if(channelMask & CH_TEMP){
+        logbuf_printf(fp, "%s%s", sep, "Temp");
+        sep = ",";
+    }
+    if(channelMask & CH_MAG){
+        logbuf_printf(fp, "%s%s,%s,%s", sep, "xMag","yMag","zMag");
+        sep = ",";
+    }
+    if(channelMask & CH_QUAT){
+        logbuf_printf(fp, "%s%s,%s,%s,%s", sep, "qw","qx","qy","qz");
+    }
+    logbuf_putc(fp, '\n');
+}
+//*********************************************************************************************
+// one value and its separator
+static char *putValue(char *p, int16_t v){
+    p = logbuf_fmt_i16(p, v);
+    *p++ = ',';
+    return p;
+}
+//*********************************************************************************************
+// Same bytes as printing the fields with "%lu" and "%d", but encoded straight
+// into the sector block: at most 10 + 14 * 7 bytes, below LOGBUF_LINE_MAX.
+void channels_write_sample(FIL *fp, const sample_t *smp){
+    char *line = logbuf_reserve(fp);
+    char *p = line;
+
+    if(channelMask & CH_TIME){
+        p = logbuf_fmt_u32(p, smp->time);
+        *p++ = ',';
+    }
+    if(channelMask & CH_ACCEL){
+        p = putValue(p, smp->xAccel);
+        p = putValue(p, smp->yAccel);
+        p = putValue(p, smp->zAccel);
+    }
+    if(channelMask & CH_GYRO){
+        p = putValue(p, smp->xGyro);
+        p = putValue(p, smp->yGyro);
+        p = putValue(p, smp->zGyro);
+    }
+    if(channelMask & CH_TEMP){
+        p = putValue(p, smp->temp);
+    }
+    if(channelMask & CH_MAG){
+        p = putValue(p, smp->xMag);
+        p = putValue(p, smp->yMag);
+        p = putValue(p, smp->zMag);
+    }
+    if(channelMask & CH_QUAT){
+        p = putValue(p, smp->q[0]);
+        p = putValue(p, smp->q[1]);
+        p = putValue(p, smp->q[2]);
+        p = putValue(p, smp->q[3]);
+    }
+    if(p == line){                  // no channel selected, empty line
+        p++;
+    }
+    p[-1] = '\n';                   // replaces the last separator
+    logbuf_commit(fp, p);
+}
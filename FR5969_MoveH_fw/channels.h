@@ -0,0 +1,47 @@
+/*
+ * channels.h
+ *
+ *  Selectable log channels. channelMask decides which sensor blocks are
+ *  read and written; the I2C burst covers only the span between the first
+ *  and last selected block, and the header and each record list only the
+ *  selected columns. The mask is kept in FRAM and can be changed with a
+ *  line "channels=agtms" (any subset) in CONFIG.TXT on the card, see
+ *  config.h: a = accel, g = gyro, t = temperature, m = magnetometer,
+ *  s = timestamp, q = orientation quaternion (ahrs.h).
+ */
+
+#ifndef CHANNELS_H_
+#define CHANNELS_H_
+
+#include <stdint.h>
+#include "./FatFS/ff.h"
+
+#define CH_TIME             0x01    // ms since session start
+#define CH_ACCEL            0x02
+#define CH_GYRO             0x04
+#define CH_TEMP             0x08
+#define CH_MAG              0x10
+#define CH_QUAT             0x20    // needs accel, gyro and mag on the device
+#define CH_DEFAULT          (CH_ACCEL | CH_GYRO | CH_MAG)
+
+// one line of the log file, unselected fields are not written
+typedef struct {
+    uint32_t time;
+    int16_t xAccel, yAccel, zAccel;
+    int16_t xGyro, yGyro, zGyro;
+    int16_t temp;
+    int16_t xMag, yMag, zMag;
+    int16_t q[4];                   // w, x, y, z in Q14
+} sample_t;
+
+extern uint8_t channelMask;
+extern uint8_t channelBurstReg;     // first register of the burst read
+extern uint8_t channelBurstLen;     // bytes per burst, 0 = no sensor channel
+
+void channels_set(const char *value);                // "channels=" from CONFIG.TXT
+void channels_layout(uint8_t extra);                 // at session start, extra: read but not logged
+void channels_parse(sample_t *smp, uint32_t time);   // burst in RX_Data -> record
+void channels_write_header(FIL *fp);
+void channels_write_sample(FIL *fp, const sample_t *smp);
+
+#endif /* CHANNELS_H_ */
@@ -0,0 +1,64 @@
+/*
+ * config.c
+ *
+ *  CONFIG.TXT reader, see config.h.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "channels.h"
+#include "wom.h"
+#include "activity.h"
+#include "trigger.h"
+#include "sdcard.h"
+#include "rotate.h"
+
+typedef struct {
+    const char *key;
+    void (*set)(const char *value);
+} config_key_t;
+
+static const config_key_t keys[] = {
+    {"channels",    channels_set},
+    {"wom_mg",      wom_set_threshold},
+    {"idle_s",      wom_set_idle},
+    {"log",         activity_set_mode},
+    {"epoch_s",     activity_set_epoch},
+    {"raw_s",       activity_set_raw},
+    {"trig_mg",     trigger_set_mg},
+    {"trig_dps",    trigger_set_dps},
+    {"trig_ext",    trigger_set_ext},
+    {"pre_ms",      trigger_set_pre},
+    {"post_ms",     trigger_set_post},
+    {"slow_div",    trigger_set_slow},
+    {"sd_busy_ms",  sd_set_busy},
+    {"sd_read_ms",  sd_set_read},
+    {"rotate_min",  rotate_set_minutes},
+    {"rotate_mb",   rotate_set_mb},
+};
+
+//*********************************************************************************************
+void config_load(FIL *fp){
+    char line[24];
+    char *value;
+    uint8_t i;
+
+    if(f_open(fp, CONFIG_FILE, FA_READ) != FR_OK){
+        return;                     // no config on the card, keep the FRAM settings
+    }
+    while(f_gets(line, sizeof(line), fp)){
+        value = strchr(line, '=');
+        if(!value){
+            continue;
+        }
+        *value++ = '\0';
+        for(i = 0; i < sizeof(keys) / sizeof(keys[0]); i++){
+            if(strcmp(line, keys[i].key) == 0){
+                keys[i].set(value);
+                break;
+            }
+        }
+    }
+    f_close(fp);
+}
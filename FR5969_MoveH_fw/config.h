@@ -0,0 +1,32 @@
+/*
+ * config.h
+ *
+ *  Settings from CONFIG.TXT on the card. Each line "key=value" is handed to
+ *  the module owning the key; unknown keys and a missing file are ignored,
+ *  so the FRAM copies of the settings stay in effect.
+ *
+ *  channels=agtms  logged channels, see channels.h
+ *  wom_mg=<mg>     wake-on-motion threshold, 0 = auto-record off, see wom.h
+ *  idle_s=<s>      inactivity that ends an auto-recorded session
+ *  log=summary     epoch summaries instead of raw samples, see activity.h
+ *  epoch_s=<s>     summary epoch length
+ *  raw_s=<s>       raw samples at the start of a summary session
+ *  trig_mg=<mg>    burst capture on |a| - 1 g, 0 = off, see trigger.h
+ *  trig_dps=<dps>  burst capture on gyro rate, 0 = off
+ *  trig_ext=1      burst capture on a falling edge of P1.1
+ *  pre_ms=, post_ms=   burst window around the trigger
+ *  slow_div=<n>    log every n-th sample outside bursts, 0 = none
+ *  sd_busy_ms=, sd_read_ms=    SD card timeouts, see sdcard.h
+ *  rotate_min=, rotate_mb=     new part of the session file, 0 = off, see rotate.h
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include "./FatFS/ff.h"
+
+#define CONFIG_FILE         "CONFIG.TXT"
+
+void config_load(FIL *fp);          // fp must be closed
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,33 @@
+/*
+ * fixmath.h
+ *
+ *  Integer helpers shared by the on-device processing (activity.c, ahrs.c).
+ */
+
+#ifndef FIXMATH_H_
+#define FIXMATH_H_
+
+#include <stdint.h>
+
+// bitwise integer square root, 16 iterations
+static inline uint16_t isqrt32(uint32_t x){
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while(bit > x){
+        bit >>= 2;
+    }
+    while(bit){
+        if(x >= root + bit){
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+#endif /* FIXMATH_H_ */
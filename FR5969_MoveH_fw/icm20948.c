@@ -0,0 +1,351 @@
+/*
+ * icm20948.c
+ *
+ *  ICM20948 I2C transport and register table engine, see icm20948.h.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "icm20948.h"
+#include "main.h"
+
+unsigned char RX_Data[23];
+unsigned char TX_Data[ICM_BURST_MAX + 1];
+unsigned char RX_ByteCtr = 0;
+unsigned char TX_ByteCtr = 0;
+uint8_t icmAccelConfig = 0;
+uint8_t icmGyroConfig = 0;
+uint8_t icmWomThreshold = 0;
+
+icm_stats_t icmStats = {0};
+
+static volatile bool i2cBusy = false;       // USCI_B0 transfer in progress
+static uint8_t icmBank = 0xFF;              // bank selected in the sensor, 0xFF = unknown
+
+// Configuration registers mirrored in SRAM. Writes update the shadow, reads
+// and read-modify-writes of a valid entry need no bus traffic. Self-clearing
+// bits are never stored. A device reset loads the datasheet reset values.
+typedef struct {
+    uint8_t bank;
+    uint8_t reg;
+    uint8_t resetValue;
+    uint8_t selfClear;
+} shadow_def_t;
+
+static const shadow_def_t shadowDefs[] = {
+    {0, ICM_USER_CTRL,      0x00, 0x0E},    // DMP_RST, SRAM_RST, I2C_MST_RST
+    {0, ICM_LP_CONFIG,      0x40, 0x00},
+    {0, ICM_PWR_MGMT_1,     0x41, 0x80},    // DEVICE_RESET
+    {0, ICM_INT_PIN_CFG,    0x00, 0x00},
+    {2, ICM_GYRO_CONFIG_1,  0x01, 0x00},    // GYRO_FCHOICE, DLPF on
+    {2, ICM_ACCEL_CONFIG,   0x01, 0x00},    // ACCEL_FCHOICE, DLPF on
+    {3, ICM_I2C_MST_CTRL,   0x00, 0x00},
+    {3, ICM_I2C_SLV0_ADDR,  0x00, 0x00},
+    {3, ICM_I2C_SLV0_REG,   0x00, 0x00},
+    {3, ICM_I2C_SLV0_CTRL,  0x00, 0x00},
+    {3, ICM_I2C_SLV4_ADDR,  0x00, 0x00},
+    {3, ICM_I2C_SLV4_REG,   0x00, 0x00},
+    {3, ICM_I2C_SLV4_CTRL,  0x00, 0x80},    // SLV4_EN clears when the transfer is done
+    {3, ICM_I2C_SLV4_DO,    0x00, 0x00},
+};
+#define SHADOW_LEN      ICM_TABLE_LEN(shadowDefs)
+#define SHADOW_NONE     0xFF
+
+static uint8_t shadowValue[SHADOW_LEN];
+static uint16_t shadowValid = 0;            // bit i set: shadowValue[i] matches the device
+
+//*********************************************************************************************
+// Power-up configuration, replayed as is after a sensor reset
+const icm_reg_t icmInitTable[] = {
+    // bank reg                  value        mask  delay src
+    {0, ICM_PWR_MGMT_1,         0b00000000,  0xFF, 3,    ICM_SRC_CONST},     // wake up, low power off
+    {0, ICM_PWR_MGMT_1,         0b10000000,  0xFF, 100,  ICM_SRC_CONST},     // ICM20948 RESET
+    {0, ICM_PWR_MGMT_1,         0b00000001,  0xFF, 10,   ICM_SRC_CONST},     // BIT6=0(wake up),BIT5=0(low power disable),BIT[2:0]=001(autoselect best clock)
+    {0, ICM_LP_CONFIG,          0b01000000,  0xFF, 0,    ICM_SRC_CONST},     // ACCEL/GYRO/I2CMST continuous
+    {0, ICM_INT_PIN_CFG,        0b00000000,  0x02, 0,    ICM_SRC_CONST},     // clear BYPASS_EN, no I2C passthrough
+    {2, ICM_GYRO_CONFIG_1,      0,           0xFF, 0,    ICM_SRC_GYRO_FS},   // selected gyro mode
+    {2, ICM_ACCEL_CONFIG,       0,           0xFF, 0,    ICM_SRC_ACCEL_FS},  // selected accel mode
+    {3, ICM_I2C_MST_CTRL,       0x17,        0x1F, 0,    ICM_SRC_CONST},     // [3:0]=7: 345.6 kHz master clock, [4]: stop between reads
+    {0, ICM_USER_CTRL,          0b00100000,  0x20, 0,    ICM_SRC_CONST},     // BIT[5]: enable I2C master
+};
+const uint8_t icmInitTableLen = ICM_TABLE_LEN(icmInitTable);
+
+// Full scale ranges from the DIP switch, applied at every session start
+const icm_reg_t icmRangeTable[] = {
+    {2, ICM_GYRO_CONFIG_1,      0,           0xFF, 0,    ICM_SRC_GYRO_FS},
+    {2, ICM_ACCEL_CONFIG,       0,           0xFF, 0,    ICM_SRC_ACCEL_FS},
+};
+const uint8_t icmRangeTableLen = ICM_TABLE_LEN(icmRangeTable);
+
+//*********************************************************************************************
+//helper function to initialize USCIB0 I2C
+void i2cInit(void)
+{
+
+    // Configure USCI_B0 for I2C mode
+     UCB0CTLW0 = UCSWRST;                      // put eUSCI_B in reset state
+     UCB0CTLW0 |= UCMODE_3 | UCMST | UCSSEL__SMCLK | UCSYNC; // I2C master mode, SMCLK
+     UCB0BRW = SMCLK_FREQUENCY / 400000;       // baudrate = SMCLK / 40 = 400kHz
+     UCB0CTLW0 &= ~UCSWRST;                    // clear reset register
+     UCB0IE |= UCTXIE0 | UCNACKIE;             // transmit and NACK interrupt enable
+}
+
+//*********************************************************************************************
+//helper function to access ICM20948 registers
+void i2cWrite(unsigned char address)
+{
+    __disable_interrupt();
+    UCB0I2CSA = address;                // Load slave address
+    UCB0IE |= UCTXIE;                   //Enable TX interrupt
+    while(UCB0CTL1 & UCTXSTP);          // Ensure stop condition sent
+    i2cBusy = true;
+    icmStats.transfers++;
+    UCB0CTL1 |= UCTR + UCTXSTT;         // TX mode and START condition
+    while(i2cBusy){                     // other ISRs may wake the CPU before the transfer is done
+        __bis_SR_register(CPUOFF + GIE);    // sleep until UCB0TXIFG is set ...
+        __disable_interrupt();
+    }
+    __enable_interrupt();
+}
+
+//*********************************************************************************************
+// helper function to read ICM20948 registers
+void i2cRead(unsigned char address)
+{
+    __disable_interrupt();
+    UCB0I2CSA = address;                // Load slave address
+    UCB0IE |= UCRXIE;                   // Enable RX interrupt
+    while(UCB0CTL1 & UCTXSTP);          // Ensure stop condition sent
+    i2cBusy = true;
+    icmStats.transfers++;
+    UCB0CTL1 &= ~UCTR;                  // RX mode
+    UCB0CTL1 |= UCTXSTT;                // Start Condition
+    while(i2cBusy){                     // other ISRs may wake the CPU before the transfer is done
+        __bis_SR_register(CPUOFF + GIE);    // sleep until UCB0RXIFG is set ...
+        __disable_interrupt();
+    }
+    __enable_interrupt();
+}
+//*********************************************************************************************
+
+void icm_delay_ms(uint8_t ms){
+    while(ms--){
+        __delay_cycles(MCLK_FREQUENCY / 1000);
+    }
+}
+//*********************************************************************************************
+
+static uint8_t findShadow(uint8_t bank, uint8_t reg){
+    uint8_t i;
+
+    for(i = 0; i < SHADOW_LEN; i++){
+        if(shadowDefs[i].bank == bank && shadowDefs[i].reg == reg){
+            return i;
+        }
+    }
+    return SHADOW_NONE;
+}
+//*********************************************************************************************
+
+void icm_invalidate(void){
+    icmBank = 0xFF;
+    shadowValid = 0;
+}
+//*********************************************************************************************
+// after DEVICE_RESET the sensor is in bank 0 with all registers at their reset values
+static void loadResetValues(void){
+    uint8_t i;
+
+    for(i = 0; i < SHADOW_LEN; i++){
+        shadowValue[i] = shadowDefs[i].resetValue;
+    }
+    shadowValid = (1u << SHADOW_LEN) - 1;
+    icmBank = 0;
+}
+//*********************************************************************************************
+
+static void selectBank(uint8_t bank){
+    if(bank == icmBank){
+        icmStats.bankSaved++;           // already there, skip the transaction
+        return;
+    }
+    TX_Data[1] = ICM_REG_BANK_SEL;
+    TX_Data[0] = bank << 4;
+    TX_ByteCtr = 2;
+    i2cWrite(ICM_ADDRESS);
+    icmBank = bank;
+}
+//*********************************************************************************************
+// write n consecutive registers starting at reg in one transaction,
+// TX_Data is sent from the top index down
+static void writeBurst(uint8_t bank, uint8_t reg, const uint8_t *values, uint8_t n){
+    uint8_t i;
+    uint8_t k;
+    bool needed = false;
+
+    // skip the write if every register already holds its value
+    for(i = 0; i < n && !needed; i++){
+        k = findShadow(bank, reg + i);
+        if(k == SHADOW_NONE || !(shadowValid & (1u << k)) ||
+           shadowValue[k] != values[i] || (values[i] & shadowDefs[k].selfClear)){
+            needed = true;
+        }
+    }
+    if(!needed){
+        icmStats.writesSaved++;
+        return;
+    }
+
+    selectBank(bank);
+    TX_Data[n] = reg;
+    for(i = 0; i < n; i++){
+        TX_Data[n - 1 - i] = values[i];
+    }
+    TX_ByteCtr = n + 1;
+    i2cWrite(ICM_ADDRESS);
+
+    if(bank == 0 && reg == ICM_PWR_MGMT_1 && (values[0] & 0x80)){
+        loadResetValues();
+        return;
+    }
+    for(i = 0; i < n; i++){
+        k = findShadow(bank, reg + i);
+        if(k != SHADOW_NONE){
+            shadowValue[k] = values[i] & ~shadowDefs[k].selfClear;
+            shadowValid |= 1u << k;
+        }
+    }
+}
+//*********************************************************************************************
+
+static uint8_t entryValue(const icm_reg_t *e){
+    switch(e->src){
+        case ICM_SRC_ACCEL_FS:
+            return icmAccelConfig;
+        case ICM_SRC_GYRO_FS:
+            return icmGyroConfig;
+        case ICM_SRC_WOM_THR:
+            return icmWomThreshold;
+        default:
+            return e->value;
+    }
+}
+//*********************************************************************************************
+//*********************************************************************************************
+
+uint8_t icm_read(uint8_t bank, uint8_t reg){
+    uint8_t k;
+
+    k = findShadow(bank, reg);
+    if(k != SHADOW_NONE && (shadowValid & (1u << k))){
+        icmStats.readsSaved++;
+        return shadowValue[k];
+    }
+
+    selectBank(bank);
+    TX_Data[0] = reg;                   // register address
+    TX_ByteCtr = 1;
+    i2cWrite(ICM_ADDRESS);
+
+    RX_ByteCtr = 2;
+    i2cRead(ICM_ADDRESS);
+    if(k != SHADOW_NONE){
+        shadowValue[k] = RX_Data[1];
+        shadowValid |= 1u << k;
+    }
+    return RX_Data[1];
+}
+//*********************************************************************************************
+
+void icm_write(uint8_t bank, uint8_t reg, uint8_t value){
+    writeBurst(bank, reg, &value, 1);
+}
+//*********************************************************************************************
+// read n bytes starting at reg into RX_Data, first byte ends up in RX_Data[n-1]
+void icm_read_burst(uint8_t bank, uint8_t reg, uint8_t n){
+    selectBank(bank);
+    TX_Data[0] = reg;
+    TX_ByteCtr = 1;
+    i2cWrite(ICM_ADDRESS);
+
+    RX_ByteCtr = n;
+    i2cRead(ICM_ADDRESS);
+}
+//*********************************************************************************************
+
+void icm_apply(const icm_reg_t *tbl, uint8_t len){
+    uint8_t values[ICM_BURST_MAX];
+    const icm_reg_t *e;
+    uint8_t i = 0;
+    uint8_t n;
+
+    while(i < len){
+        e = &tbl[i];
+        n = 1;
+        if(e->mask != 0xFF){            // read-modify-write
+            values[0] = (icm_read(e->bank, e->reg) & ~e->mask) | (entryValue(e) & e->mask);
+        }
+        else{                           // collect following registers of the same bank into one burst
+            values[0] = entryValue(e);
+            while(i + n < len && n < ICM_BURST_MAX &&
+                  tbl[i + n - 1].delayMs == 0 &&
+                  tbl[i + n].mask == 0xFF &&
+                  tbl[i + n].bank == e->bank &&
+                  tbl[i + n].reg == e->reg + n){
+                values[n] = entryValue(&tbl[i + n]);
+                n++;
+            }
+        }
+        writeBurst(e->bank, e->reg, values, n);
+        icm_delay_ms(tbl[i + n - 1].delayMs);
+        i += n;
+    }
+}
+//*********************************************************************************************
+
+void icm_clear_stats(void){
+    icmStats.transfers = 0;
+    icmStats.bankSaved = 0;
+    icmStats.readsSaved = 0;
+    icmStats.writesSaved = 0;
+}
+//*********************************************************************************************
+
+/**********************************************************************************************/
+// Sensor I2C ISR
+#pragma vector = USCI_B0_VECTOR
+__interrupt void USCI_B0_ISR(void)
+{
+    if(UCB0CTL1 & UCTR)                 // TX mode (UCTR == 1)
+    {
+        if (TX_ByteCtr)                     // TRUE if more bytes remain
+        {
+            TX_ByteCtr--;               // Decrement TX byte counter
+            UCB0TXBUF = TX_Data[TX_ByteCtr];    // Load TX buffer
+        }
+        else                        // no more bytes to send
+        {
+            UCB0CTL1 |= UCTXSTP;            // I2C stop condition
+            UCB0IFG &= ~UCTXIFG;         // Clear USCI_B0 TX int flag
+            i2cBusy = false;
+            __bic_SR_register_on_exit(CPUOFF);  // Exit LPM0
+        }
+    }
+    else // (UCTR == 0)                 // RX mode
+    {
+        RX_ByteCtr--;                       // Decrement RX byte counter
+        if (RX_ByteCtr)                     // RxByteCtr != 0
+        {
+            RX_Data[RX_ByteCtr] = UCB0RXBUF;    // Get received byte
+            if (RX_ByteCtr == 1)            // Only one byte left?
+            UCB0CTL1 |= UCTXSTP;            // Generate I2C stop condition
+        }
+        else                        // RxByteCtr == 0
+        {
+            RX_Data[RX_ByteCtr] = UCB0RXBUF;    // Get final received byte
+            i2cBusy = false;
+            __bic_SR_register_on_exit(CPUOFF);  // Exit LPM0
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * icm20948.h
+ *
+ *  ICM20948 access over USCI_B0 I2C. Configuration is described by const
+ *  register tables that icm_apply() plays back: REG_BANK_SEL is only written
+ *  when the bank changes, runs of consecutive registers in one bank go out
+ *  as a single burst write, and masked entries become read-modify-writes.
+ *  The selected bank and the configuration registers are shadowed in SRAM,
+ *  so bank selects, reads, read-modify-writes and writes of an unchanged
+ *  value are served without bus traffic. All sensor accesses have to go
+ *  through this module so the shadow stays in sync with the device.
+ */
+
+#ifndef ICM20948_H_
+#define ICM20948_H_
+
+#include <stdint.h>
+
+#define ICM_ADDRESS         0x69    // 0x68 for ADD pin=0 / 0x69 for ADD pin=1
+#define ICM_BURST_MAX       7       // data bytes per burst write
+
+// bank 0
+#define ICM_USER_CTRL       0x03
+#define ICM_LP_CONFIG       0x05
+#define ICM_PWR_MGMT_1      0x06
+#define ICM_PWR_MGMT_2      0x07
+#define ICM_INT_PIN_CFG     0x0F
+#define ICM_INT_ENABLE      0x10
+#define ICM_I2C_MST_STATUS  0x17
+#define ICM_INT_STATUS      0x19
+#define ICM_ACCEL_XOUT_H    0x2D
+// bank 2
+#define ICM_GYRO_CONFIG_1   0x01
+#define ICM_ACCEL_SMPLRT_DIV_1  0x10
+#define ICM_ACCEL_SMPLRT_DIV_2  0x11
+#define ICM_ACCEL_INTEL_CTRL    0x12
+#define ICM_ACCEL_WOM_THR   0x13
+#define ICM_ACCEL_CONFIG    0x14
+// bank 3
+#define ICM_I2C_MST_CTRL    0x01
+#define ICM_I2C_SLV0_ADDR   0x03
+#define ICM_I2C_SLV0_REG    0x04
+#define ICM_I2C_SLV0_CTRL   0x05
+#define ICM_I2C_SLV4_ADDR   0x13
+#define ICM_I2C_SLV4_REG    0x14
+#define ICM_I2C_SLV4_CTRL   0x15
+#define ICM_I2C_SLV4_DO     0x16
+#define ICM_I2C_SLV4_DI     0x17
+// all banks
+#define ICM_REG_BANK_SEL    0x7F
+
+// icm_reg_t.src: where the value of an entry comes from
+#define ICM_SRC_CONST       0       // value field
+#define ICM_SRC_ACCEL_FS    1       // icmAccelConfig (DIP switch)
+#define ICM_SRC_GYRO_FS     2       // icmGyroConfig (DIP switch)
+#define ICM_SRC_WOM_THR     3       // icmWomThreshold (CONFIG.TXT)
+
+typedef struct {
+    uint8_t bank;                   // 0..3
+    uint8_t reg;
+    uint8_t value;
+    uint8_t mask;                   // bits taken from value, 0xFF = plain write, else read-modify-write
+    uint8_t delayMs;                // settle time after the write
+    uint8_t src;                    // ICM_SRC_*
+} icm_reg_t;
+
+// bus transactions issued and avoided since icm_clear_stats(), i.e. in the session
+typedef struct {
+    uint32_t transfers;             // I2C transfers (address + data phase)
+    uint32_t bankSaved;             // REG_BANK_SEL writes skipped
+    uint32_t readsSaved;            // register reads served from the shadow
+    uint32_t writesSaved;           // writes skipped, value already in place
+} icm_stats_t;
+
+#define ICM_TABLE_LEN(t)    (sizeof(t) / sizeof((t)[0]))
+
+extern unsigned char RX_Data[23];
+extern unsigned char TX_Data[ICM_BURST_MAX + 1];
+extern unsigned char RX_ByteCtr;
+extern unsigned char TX_ByteCtr;
+extern uint8_t icmAccelConfig;      // ACCEL_CONFIG value for ICM_SRC_ACCEL_FS
+extern uint8_t icmGyroConfig;       // GYRO_CONFIG_1 value for ICM_SRC_GYRO_FS
+extern uint8_t icmWomThreshold;     // ACCEL_WOM_THR value for ICM_SRC_WOM_THR, 4 mg/LSB
+
+extern icm_stats_t icmStats;
+
+extern const icm_reg_t icmInitTable[];
+extern const uint8_t icmInitTableLen;
+extern const icm_reg_t icmRangeTable[];
+extern const uint8_t icmRangeTableLen;
+
+void i2cInit(void);
+void i2cWrite(unsigned char);
+void i2cRead(unsigned char);
+
+void icm_apply(const icm_reg_t *tbl, uint8_t len);
+void icm_clear_stats(void);
+void icm_write(uint8_t bank, uint8_t reg, uint8_t value);
+uint8_t icm_read(uint8_t bank, uint8_t reg);
+void icm_read_burst(uint8_t bank, uint8_t reg, uint8_t n);     // into RX_Data, first byte in RX_Data[n-1]
+void icm_delay_ms(uint8_t ms);
+void icm_invalidate(void);          // forget bank and shadow, e.g. after a bus error
+
+#endif /* ICM20948_H_ */
@@ -0,0 +1,305 @@
+/*
+ * journal.c
+ *
+ *  Commit records for power-loss-safe logging, see journal.h.
+ *
+ *  The session file is grown with f_lseek in JOURNAL_RESERVE steps, carried
+ *  on to the end of a card allocation unit, and the FAT chain plus directory
+ *  entry are synced once per step, into the FRAM window cache (_FS_WINCACHE)
+ *  that the next mount writes to the card. Between steps f_write only
+ *  overwrites sectors inside the extent, so the FAT never has to change and a
+ *  brown-out cannot leave it inconsistent. What is lost on power failure is
+ *  the directory size (it still covers the whole extent), which
+ *  journal_recover() repairs from the FRAM commit record.
+ *
+ *  A rotated session moves on to a part that was created and extended ahead
+ *  of time. The record names it until the switch, which moves the commit to
+ *  its start in one record write: before that recovery repairs the old part
+ *  and deletes the new one, after it recovery repairs the new part.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "journal.h"
+#include "logbuf.h"
+
+#define JOURNAL_MAGIC       0x4A52      // "JR"
+
+// Two commit records in FRAM, written alternately. A power loss in the middle
+// of a commit leaves a slot with a bad CRC and the other slot still valid.
+#pragma PERSISTENT(journalSlot)
+journal_rec_t journalSlot[2] = {0};
+
+static journal_rec_t rec;               // working copy of the current record
+static uint8_t active = 0;              // slot holding the newest valid record
+
+//*********************************************************************************************
+// CRC16-CCITT using the hardware CRC module
+static uint16_t crc16(const uint8_t *data, uint16_t len){
+    CRCINIRES = 0xFFFF;
+    while(len--){
+        CRCDI_L = *data++;
+    }
+    return CRCINIRES;
+}
+//*********************************************************************************************
+
+static bool slotValid(const journal_rec_t *r){
+    return (r->magic == JOURNAL_MAGIC) &&
+           (r->crc == crc16((const uint8_t *)r, offsetof(journal_rec_t, crc)));
+}
+//*********************************************************************************************
+// load the newest valid slot into rec, returns false if FRAM holds no record yet
+static bool loadNewest(void){
+    bool v0 = slotValid(&journalSlot[0]);
+    bool v1 = slotValid(&journalSlot[1]);
+
+    if(v0 && v1){
+        active = ((int16_t)(journalSlot[1].seq - journalSlot[0].seq) > 0) ? 1 : 0;
+    }
+    else if(v0){
+        active = 0;
+    }
+    else if(v1){
+        active = 1;
+    }
+    else{
+        memset(&rec, 0, sizeof(rec));
+        return false;
+    }
+    rec = journalSlot[active];
+    return true;
+}
+//*********************************************************************************************
+// commit rec into the older slot
+static void writeRecord(void){
+    rec.magic = JOURNAL_MAGIC;
+    rec.seq++;
+    rec.crc = crc16((const uint8_t *)&rec, offsetof(journal_rec_t, crc));
+    active ^= 1;
+    journalSlot[active] = rec;
+}
+//*********************************************************************************************
+// bytes of the file that are already on the card: everything up to the sector
+// held in the FIL buffer, or everything if that buffer is clean
+static uint32_t bytesOnCard(const FIL *fp){
+    if((fp->flag & FA__DIRTY) && fp->fptr){
+        return (fp->fptr - 1) & ~(uint32_t)(_MAX_SS - 1);
+    }
+    return fp->fptr;
+}
+//*********************************************************************************************
+// stretch the cluster chain by JOURNAL_RESERVE bytes past the write pointer and
+// put FAT and directory entry on the card, then return to the write pointer.
+// The file is opened with FA_ALIGN, so the extent goes on to the end of the
+// card's allocation unit it stops in: every AU is written in order to its end.
+static FRESULT extendExtent(FIL *fp){
+    DWORD pos = fp->fptr;
+    DWORD end = pos + JOURNAL_RESERVE;
+    DWORD au = fp->fs->au * fp->fs->csize;      // sectors, 0 without AU placement
+    DWORD sect;
+    FRESULT fr;
+
+    fr = f_lseek(fp, end);
+    if(fr == FR_OK && au && fp->fptr == end){
+        sect = clust2sect(fp->fs, fp->clust) + (end - 1) / _MAX_SS % fp->fs->csize;    // last sector
+        end += (au - 1 - sect % au) * (DWORD)_MAX_SS;
+        fr = f_lseek(fp, end);
+    }
+    if(fr == FR_OK && fp->fptr != end){
+        fr = FR_DENIED;                 // card full, chain was clipped
+    }
+    if(fp->fsize > pos){
+        FRESULT fs = f_sync(fp);
+        if(fr == FR_OK) fr = fs;
+    }
+    if(f_lseek(fp, pos) != FR_OK && fr == FR_OK){
+        fr = FR_DISK_ERR;
+    }
+    return fr;
+}
+//*********************************************************************************************
+// delete the part prepared ahead, the record stays as it is
+static FRESULT removeNext(void){
+    FRESULT fr = FR_OK;
+
+    if(rec.next[0]){
+        fr = f_unlink(rec.next);
+        if(fr == FR_NO_FILE){
+            fr = FR_OK;             // removed before the record was written
+        }
+    }
+    return fr;
+}
+//*********************************************************************************************
+//*********************************************************************************************
+// Trim the file of a session that was interrupted by power loss down to the
+// committed size. fp is only used as scratch object and must not be open.
+FRESULT journal_recover(FIL *fp){
+    FRESULT fr;
+
+    if(!loadNewest() || rec.state != JOURNAL_OPEN){
+        return FR_OK;
+    }
+
+    fr = removeNext();
+    if(fr != FR_OK){
+        return fr;
+    }
+    fr = f_open(fp, rec.name, FA_WRITE | FA_OPEN_EXISTING);
+    if(fr == FR_OK){
+        if(rec.committed < fp->fsize){
+            fr = f_lseek(fp, rec.committed);
+            if(fr == FR_OK) fr = f_truncate(fp);
+        }
+        if(fr == FR_OK) fr = logbuf_recover(fp);    // lines still in the FRAM block
+        if(f_close(fp) != FR_OK && fr == FR_OK){
+            fr = FR_DISK_ERR;
+        }
+    }
+    else if(fr == FR_NO_FILE){
+        fr = FR_OK;                     // file is gone, nothing to repair
+    }
+
+    if(fr == FR_OK){
+        rec.state = JOURNAL_IDLE;
+        rec.next[0] = 0;
+        writeRecord();
+        logbuf_discard();               // lines are in the file for good
+    }
+    return fr;
+}
+//*********************************************************************************************
+// start journaling a freshly opened session file
+FRESULT journal_open(FIL *fp, const char *name){
+    loadNewest();
+
+    strncpy(rec.name, name, sizeof(rec.name) - 1);
+    rec.name[sizeof(rec.name) - 1] = 0;
+    rec.next[0] = 0;
+    rec.committed = fp->fptr;
+    rec.reserved = fp->fsize;
+    rec.state = JOURNAL_OPEN;
+    writeRecord();                      // name is known before the FAT is touched
+
+    // The first cluster goes into the directory entry on its own: a power
+    // loss while the chain is stretched then leaves it reachable for the
+    // truncation in journal_recover(), not lost on the card.
+    FRESULT fr = FR_OK;
+    if(!fp->sclust){
+        fr = f_lseek(fp, 1);
+        if(fr == FR_OK) fr = f_sync(fp);
+        if(fr == FR_OK) fr = f_lseek(fp, 0);
+    }
+    if(fr == FR_OK) fr = extendExtent(fp);
+    rec.reserved = fp->fsize;
+    writeRecord();
+    return fr;
+}
+//*********************************************************************************************
+// Record how much of the file is on the card. Only writes FRAM when a sector
+// went out, and only touches the card when the extent is about to run out.
+FRESULT journal_commit(FIL *fp){
+    FRESULT fr = FR_OK;
+    uint32_t onCard = bytesOnCard(fp);
+    bool dirty = false;
+
+    if(onCard != rec.committed){
+        rec.committed = onCard;
+        dirty = true;
+    }
+    if(fp->fptr + JOURNAL_MARGIN > rec.reserved){
+        fr = extendExtent(fp);
+        rec.reserved = fp->fsize;
+        dirty = true;
+    }
+    if(dirty){
+        writeRecord();
+    }
+    return fr;
+}
+//*********************************************************************************************
+// Open the session file again after the volume was remounted. Whatever was
+// written after the last commit may not have reached the card and is
+// overwritten; the extent is already on the card, so rec.reserved still holds.
+FRESULT journal_reopen(FIL *fp){
+    FRESULT fr = f_open(fp, rec.name, FA_WRITE | FA_OPEN_EXISTING | FA_ALIGN);
+
+    if(fr == FR_OK){
+        fr = f_lseek(fp, rec.committed);
+    }
+    return fr;
+}
+//*********************************************************************************************
+// hand back the unused part of the extent and close the file
+FRESULT journal_close(FIL *fp){
+    FRESULT fr = f_truncate(fp);
+    FRESULT fc = f_close(fp);
+
+    if(fr == FR_OK) fr = fc;
+    if(fr == FR_OK){                    // otherwise leave the record open for journal_recover
+        rec.committed = fp->fsize;
+        rec.state = JOURNAL_IDLE;
+        writeRecord();
+    }
+    return fr;
+}
+//*********************************************************************************************
+// Create the next part of the session file and put its first extent on the
+// card while the current part is still written. Its name is in the record
+// before the FAT is touched.
+FRESULT journal_prepare(FIL *next, const char *name){
+    FRESULT fr;
+
+    strncpy(rec.next, name, sizeof(rec.next) - 1);
+    rec.next[sizeof(rec.next) - 1] = 0;
+    writeRecord();
+
+    fr = f_open(next, name, FA_WRITE | FA_CREATE_ALWAYS | FA_ALIGN);
+    if(fr == FR_OK){
+        fr = extendExtent(next);
+        if(fr == FR_OK){
+            fr = f_release(next);       // clean, the pool buffer is free for the open parts
+        }
+        if(fr != FR_OK){
+            f_close(next);              // the record still names it, retried or deleted later
+        }
+    }
+    return fr;
+}
+//*********************************************************************************************
+// Trim and close the current part like journal_close and go on in the
+// prepared one. The FIL of the next part moves into fp, next is free again.
+FRESULT journal_rotate(FIL *fp, FIL *next){
+    FRESULT fr = f_truncate(fp);
+    FRESULT fc = f_close(fp);
+
+    if(fr == FR_OK) fr = fc;
+    if(fr != FR_OK){
+        return fr;                      // the record still covers fp and keeps next
+    }
+    memcpy(rec.name, rec.next, sizeof(rec.name));
+    rec.next[0] = 0;
+    rec.committed = next->fptr;
+    rec.reserved = next->fsize;
+    writeRecord();
+
+    *fp = *next;                        // holds no pool buffer after journal_prepare
+    next->fs = 0;
+    return FR_OK;
+}
+//*********************************************************************************************
+// The session ended before the switch: delete the prepared part. The FIL of
+// it has to be closed, or stale after a remount.
+FRESULT journal_discard(void){
+    FRESULT fr = removeNext();
+
+    if(fr == FR_OK && rec.next[0]){
+        rec.next[0] = 0;
+        writeRecord();
+    }
+    return fr;
+}
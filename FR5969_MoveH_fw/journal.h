@@ -0,0 +1,47 @@
+/*
+ * journal.h
+ *
+ *  Power-loss-safe logging: session files are written into a pre-allocated
+ *  extent whose FAT chain is already on the card, and the number of bytes
+ *  that really reached the card is committed to a record in FRAM.
+ *  journal_recover() trims the file of an interrupted session at boot.
+ *  The next part of a rotated session file is prepared the same way and
+ *  named in the record, so recovery deletes it if the switch never came.
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+#include "./FatFS/ff.h"
+
+#define JOURNAL_RESERVE     0x400000UL  // bytes pre-allocated per extension (4 MB)
+#define JOURNAL_MARGIN      0x1000UL    // extend when less than this is left in the extent
+
+// journal_rec_t.state
+#define JOURNAL_IDLE        0           // no session open, nothing to repair
+#define JOURNAL_OPEN        1           // session running or interrupted by power loss
+
+typedef struct {
+    uint16_t magic;                     // JOURNAL_MAGIC when the slot has ever been written
+    uint16_t seq;                       // incremented on every commit, newest slot wins
+    uint16_t state;                     // JOURNAL_IDLE / JOURNAL_OPEN
+    char     name[13];                  // 8.3 name of the session file
+    uint8_t  pad;
+    uint32_t committed;                 // bytes of the file known to be on the card
+    uint32_t reserved;                  // size of the pre-allocated extent
+    char     next[13];                  // prepared next part, "" = none
+    uint8_t  pad2;
+    uint16_t crc;                       // CRC16-CCITT over all preceding bytes
+} journal_rec_t;
+
+FRESULT journal_recover(FIL *fp);                           // once after f_mount, fp is scratch
+FRESULT journal_open(FIL *fp, const char *name);            // after f_open of a new session file
+FRESULT journal_commit(FIL *fp);                            // after every record, cheap
+FRESULT journal_reopen(FIL *fp);                            // after a remount, resumes at the last commit
+FRESULT journal_close(FIL *fp);                             // instead of f_close
+FRESULT journal_prepare(FIL *next, const char *name);       // create the next part with its first extent
+FRESULT journal_rotate(FIL *fp, FIL *next);                 // close fp, the session goes on in next, now fp
+FRESULT journal_discard(void);                              // delete the prepared part, after f_close of it
+
+#endif /* JOURNAL_H_ */
@@ -133,6 +133,7 @@ SECTIONS
     GROUP(READ_WRITE_MEMORY)
     {
        .TI.persistent : {}                  /* For #pragma persistent            */
+       .fram_buffers  : {}                  /* Large buffers, DATA_SECTION       */
        .cio           : {}                  /* C I/O Buffer                      */
        .sysmem        : {}                  /* Dynamic memory allocation area    */
     } PALIGN(0x0400), RUN_END(fram_rx_start) > 0x4400
@@ -0,0 +1,357 @@
+/*
+ * logbuf.c
+ *
+ *  Sector-aligned session file writer, see logbuf.h.
+ */
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include "logbuf.h"
+#include "journal.h"
+
+typedef struct {
+    uint32_t base;                  // file offset of block[0]
+    uint16_t limit;                 // block size up to the next block boundary of the file
+    uint16_t len;                   // bytes in the block
+    uint16_t done;                  // bytes up to the last complete line
+} logbuf_state_t;
+
+// Block and state stay in FRAM across a power loss. done is only advanced
+// after the bytes of a line are stored, so recovery never sees half a line.
+#pragma PERSISTENT(block)
+static char block[LOGBUF_SECTORS_MAX * _MAX_SS + LOGBUF_LINE_MAX] = {0};
+#pragma PERSISTENT(state)
+static volatile logbuf_state_t state = {0, _MAX_SS, 0, 0};
+
+// Lines reserved while the block could not be emptied are encoded here and
+// counted as dropped.
+#pragma PERSISTENT(discard)
+static char discard[LOGBUF_LINE_MAX] = {0};
+static char *line = block;          // last logbuf_reserve()
+static uint16_t blockSize = _MAX_SS;    // bytes per f_write, whole sectors
+
+static logbuf_stats_t stats;
+static FFSTATS ffStart;             // FfStats at logbuf_open
+
+// "00".."99", two digits per lookup
+static const char digitPairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+//*********************************************************************************************
+// the block starts at the file pointer, the first one ends at a block boundary
+static void restart(FIL *fp){
+    state.len = 0;
+    state.done = 0;
+    state.base = fp->fptr;
+    state.limit = blockSize - (uint16_t)(fp->fptr % blockSize);
+}
+//*********************************************************************************************
+// a block that runs over a cluster end still works, f_write splits it there
+void logbuf_set_sectors(uint8_t n){
+    if(n < 1){
+        n = 1;
+    }
+    if(n > LOGBUF_SECTORS_MAX){
+        n = LOGBUF_SECTORS_MAX;
+    }
+    blockSize = (uint16_t)n * _MAX_SS;
+}
+//*********************************************************************************************
+void logbuf_open(FIL *fp){
+    restart(fp);
+    memset(&stats, 0, sizeof(stats));
+    ffStart = FfStats;
+}
+//*********************************************************************************************
+void logbuf_resume(FIL *fp){
+    if(fp->fptr != state.base){     // commit and block disagree, the block is lost
+        stats.dropped += state.len;
+        restart(fp);
+    }
+}
+//*********************************************************************************************
+// hand the block to FatFs and move the journal commit to its end
+static FRESULT writeBlock(FIL *fp){
+    FRESULT fr;
+    UINT bw;
+
+    fr = f_write(fp, block, (state.len < state.limit) ? state.len : state.limit, &bw);
+    if(bw){
+        if(fr == FR_OK){
+            fr = journal_commit(fp);
+        }
+        state.base += bw;
+        state.len -= bw;
+        state.done = (state.done > bw) ? state.done - bw : 0;
+        state.limit = blockSize - (uint16_t)(state.base % blockSize);   // a partial write leaves base unaligned
+        if(state.len){              // partial write or overhang, keep the rest at the front
+            memmove(block, block + bw, state.len);
+        }
+    }
+    return fr;
+}
+//*********************************************************************************************
+void logbuf_putc(FIL *fp, char c){
+    if(state.len >= state.limit){   // last block was not taken, try again
+        if(writeBlock(fp) != FR_OK || state.len >= state.limit){
+            stats.dropped++;
+            return;
+        }
+    }
+    block[state.len++] = c;
+    if(c == '\n'){
+        state.done = state.len;
+        stats.lines++;
+    }
+    if(state.len == state.limit){
+        writeBlock(fp);             // an error stays in fp->err for the caller
+    }
+}
+//*********************************************************************************************
+void logbuf_printf(FIL *fp, const char *fmt, ...){
+    va_list arp;
+    char c, s[11], *p;
+    uint8_t isLong, neg;
+    uint32_t v;
+
+    va_start(arp, fmt);
+    while((c = *fmt++) != 0){
+        if(c != '%'){
+            logbuf_putc(fp, c);
+            continue;
+        }
+        c = *fmt++;
+        isLong = (c == 'l');
+        if(isLong){
+            c = *fmt++;
+        }
+        switch(c){
+            case 's':
+                for(p = va_arg(arp, char *); *p; p++){
+                    logbuf_putc(fp, *p);
+                }
+                continue;
+            case 'c':
+                logbuf_putc(fp, (char)va_arg(arp, int));
+                continue;
+            case 'd':
+                v = isLong ? (uint32_t)va_arg(arp, long) : (uint32_t)(long)va_arg(arp, int);
+                break;
+            case 'u':
+                v = isLong ? va_arg(arp, unsigned long) : (uint32_t)va_arg(arp, unsigned int);
+                break;
+            case 0:
+                va_end(arp);
+                return;
+            default:                // unknown type is passed through like f_printf does
+                logbuf_putc(fp, c);
+                continue;
+        }
+        neg = (c == 'd') && (v & 0x80000000UL);
+        if(neg){
+            v = 0 - v;
+        }
+        if(neg){
+            logbuf_putc(fp, '-');
+        }
+        *logbuf_fmt_u32(s, v) = 0;
+        for(p = s; *p; p++){
+            logbuf_putc(fp, *p);
+        }
+    }
+    va_end(arp);
+}
+//*********************************************************************************************
+char *logbuf_reserve(FIL *fp){
+    if(state.len >= state.limit){   // last block was not taken, try again
+        if(writeBlock(fp) != FR_OK || state.len >= state.limit){
+            line = discard;
+            return line;
+        }
+    }
+    line = block + state.len;
+    return line;
+}
+//*********************************************************************************************
+void logbuf_commit(FIL *fp, const char *end){
+    if(line == discard){
+        stats.dropped += end - discard;
+        return;
+    }
+    state.len = end - block;
+    state.done = state.len;
+    stats.lines++;
+    if(state.len >= state.limit){
+        writeBlock(fp);             // an error stays in fp->err for the caller
+    }
+}
+//*********************************************************************************************
+// Decimal conversion without division: quotients by 100 and 10000 come from
+// multiplications with scaled reciprocals (MPY32), exact over the ranges
+// they are used for, and two digits at a time are copied from digitPairs.
+
+// v < 10000 as four digits with leading zeros
+static char *put4(char *p, uint16_t v){
+    uint16_t hi = (uint16_t)(((uint32_t)v * 5243) >> 19);     // v / 100
+    const char *d = &digitPairs[2 * hi];
+
+    p[0] = d[0];
+    p[1] = d[1];
+    d = &digitPairs[2 * (v - hi * 100)];
+    p[2] = d[0];
+    p[3] = d[1];
+    return p + 4;
+}
+//*********************************************************************************************
+// v < 10000 without leading zeros
+static char *putShort(char *p, uint16_t v){
+    uint16_t hi;
+    const char *d;
+
+    if(v < 10){
+        *p++ = '0' + (char)v;
+        return p;
+    }
+    if(v >= 100){
+        hi = (uint16_t)(((uint32_t)v * 5243) >> 19);
+        v -= hi * 100;
+        if(hi < 10){
+            *p++ = '0' + (char)hi;
+        }
+        else{
+            d = &digitPairs[2 * hi];
+            p[0] = d[0];
+            p[1] = d[1];
+            p += 2;
+        }
+    }
+    d = &digitPairs[2 * v];
+    p[0] = d[0];
+    p[1] = d[1];
+    return p + 2;
+}
+//*********************************************************************************************
+char *logbuf_fmt_u16(char *p, uint16_t v){
+    uint16_t hi;
+
+    if(v < 10000){
+        return putShort(p, v);
+    }
+    hi = (uint16_t)(((uint32_t)(v >> 4) * 6711) >> 22);        // v / 10000
+    *p++ = '0' + (char)hi;
+    return put4(p, v - hi * 10000);
+}
+//*********************************************************************************************
+char *logbuf_fmt_i16(char *p, int16_t v){
+    if(v < 0){
+        *p++ = '-';
+        return logbuf_fmt_u16(p, (uint16_t)0 - (uint16_t)v);
+    }
+    return logbuf_fmt_u16(p, (uint16_t)v);
+}
+//*********************************************************************************************
+char *logbuf_fmt_u32(char *p, uint32_t v){
+    uint32_t q;
+    uint16_t hi;
+
+    if(v <= 0xFFFF){
+        return logbuf_fmt_u16(p, (uint16_t)v);
+    }
+    q = (uint32_t)(((uint64_t)v * 0xD1B71759UL) >> 45);       // v / 10000
+    if(q <= 0xFFFF){
+        p = logbuf_fmt_u16(p, (uint16_t)q);
+    }
+    else{                           // q < 429497
+        hi = (uint16_t)(((q >> 4) * 6711) >> 22);
+        p = putShort(p, hi);
+        p = put4(p, (uint16_t)(q - (uint32_t)hi * 10000));
+    }
+    return put4(p, (uint16_t)(v - q * 10000));
+}
+//*********************************************************************************************
+// a full block the card did not take is written now instead of with the next byte
+FRESULT logbuf_retry(FIL *fp){
+    if(state.len >= state.limit){
+        return writeBlock(fp);
+    }
+    return FR_OK;
+}
+//*********************************************************************************************
+// The partial last block stays in FRAM until it is synced and committed, a
+// power loss before that is repaired by logbuf_recover() like any other.
+FRESULT logbuf_flush(FIL *fp){
+    FRESULT fr = FR_OK;
+    uint16_t len;
+    UINT bw;
+
+    while(state.len >= state.limit && fr == FR_OK){    // overhang of a reserved line takes a second write
+        len = state.len;
+        fr = writeBlock(fp);
+        if(state.len == len){       // card full
+            break;
+        }
+    }
+    if(fr == FR_OK && state.len < state.limit && state.len){
+        fr = f_write(fp, block, state.len, &bw);
+        stats.dropped += state.len - bw;    // card full
+        if(fr == FR_OK){
+            fr = f_sync(fp);
+        }
+        if(fr == FR_OK){
+            fr = journal_commit(fp);
+        }
+    }
+    if(fr == FR_OK){
+        restart(fp);
+    }
+    return fr;
+}
+//*********************************************************************************************
+// The file was trimmed to the journal commit. If that is where the block
+// begins, its complete lines are the records written after the last commit.
+// The block is kept: a power loss before journal_recover() closed the record
+// trims the file to the same commit again and the lines are appended again.
+FRESULT logbuf_recover(FIL *fp){
+    FRESULT fr = FR_OK;
+    UINT bw;
+
+    if(state.done && fp->fsize == state.base){
+        fr = f_lseek(fp, state.base);
+        if(fr == FR_OK){
+            fr = f_write(fp, block, state.done, &bw);
+        }
+    }
+    return fr;
+}
+//*********************************************************************************************
+void logbuf_discard(void){
+    state.len = 0;
+    state.done = 0;
+}
+//*********************************************************************************************
+void logbuf_stats(logbuf_stats_t *st){
+    *st = stats;
+    st->writes = FfStats.writes - ffStart.writes;
+    st->copied = FfStats.copied - ffStart.copied;
+    st->fills = FfStats.fills - ffStart.fills;
+    st->evicts = FfStats.evicts - ffStart.evicts;
+    st->meta = FfStats.meta - ffStart.meta;
+}
+//*********************************************************************************************
+void logbuf_write_stats(FIL *fp){
+    logbuf_stats_t st;
+
+    logbuf_stats(&st);
+    f_printf(fp, "%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", "io", st.lines, st.writes, st.copied, st.fills, st.dropped, st.evicts, st.meta);
+}
@@ -0,0 +1,57 @@
+/*
+ * logbuf.h
+ *
+ *  Sector-aligned writer for the session file. Records are formatted
+ *  straight into a block of one or more sectors in FRAM whose start lines up
+ *  with a block of the file. A full block goes to f_write in one call, which
+ *  FatFs hands to disk_write directly: no copy through the FIL buffer, no
+ *  read of the sector before it is overwritten, and one multiple block write
+ *  for blocks of more than one sector. The journal is committed right after
+ *  every block, so the committed size always ends where the block begins.
+ *  The block survives a power loss and journal_recover() appends the
+ *  complete lines in it to the trimmed file.
+ *
+ *  Sample lines skip the format string: the caller encodes the line with
+ *  the logbuf_fmt_* functions at the pointer from logbuf_reserve() and ends
+ *  it with logbuf_commit(). Up to LOGBUF_LINE_MAX bytes may run past the
+ *  sector boundary, they are moved to the front of the next block.
+ */
+
+#ifndef LOGBUF_H_
+#define LOGBUF_H_
+
+#include <stdint.h>
+#include "./FatFS/ff.h"
+
+#define LOGBUF_SECTORS_MAX  4       // largest block, in sectors
+#define LOGBUF_LINE_MAX     128     // longest line for logbuf_reserve()
+
+// write path counters of the running session
+typedef struct {
+    uint32_t lines;                 // '\n' written
+    uint32_t dropped;               // bytes lost while the card did not take a block
+    uint32_t writes;                // f_write calls, all files
+    uint32_t copied;                // bytes copied through FIL buffers
+    uint32_t fills;                 // sectors read before a partial write
+    uint32_t evicts;                // pool buffers taken from another file
+    uint32_t meta;                  // FAT and directory sectors written, all files
+} logbuf_stats_t;
+
+void logbuf_set_sectors(uint8_t n);                 // block size while no session is open, 1..LOGBUF_SECTORS_MAX
+void logbuf_open(FIL *fp);                          // after journal_open, before the first record
+void logbuf_resume(FIL *fp);                        // after journal_reopen, keeps the block if it still fits
+void logbuf_putc(FIL *fp, char c);
+void logbuf_printf(FIL *fp, const char *fmt, ...);  // f_printf subset: %d %u %ld %lu %s %c, no width
+char *logbuf_reserve(FIL *fp);                      // room for LOGBUF_LINE_MAX bytes
+void logbuf_commit(FIL *fp, const char *end);       // line up to end, including its '\n'
+char *logbuf_fmt_i16(char *p, int16_t v);           // same digits as "%d", returns the end
+char *logbuf_fmt_u16(char *p, uint16_t v);          // "%u"
+char *logbuf_fmt_u32(char *p, uint32_t v);          // "%lu"
+FRESULT logbuf_retry(FIL *fp);                      // after a write error, the block the card missed
+FRESULT logbuf_flush(FIL *fp);                      // rest of the block, before journal_close
+FRESULT logbuf_recover(FIL *fp);                    // from journal_recover, fp trimmed to the commit
+void logbuf_discard(void);                          // from journal_recover, once the record is closed
+void logbuf_stats(logbuf_stats_t *st);              // counters since logbuf_open
+void logbuf_write_stats(FIL *fp);                   // "io,<lines>,<f_write>,<copied>,<fills>,<dropped>,<evicts>,<meta>" to another file
+
+#endif /* LOGBUF_H_ */
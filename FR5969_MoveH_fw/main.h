@@ -9,5 +9,6 @@
 #define MAIN_H_
 
 #define MCLK_FREQUENCY 16000000		// Used in mmc.c but is project specific
+#define SMCLK_FREQUENCY MCLK_FREQUENCY	// SMCLK = MCLK = DCO, clocks the I2C and SPI buses
 
 #endif /* MAIN_H_ */
@@ -4,6 +4,22 @@
 #include <stdbool.h>
 #include "./FatFS/ff.h"
 #include "./FatFS/diskio.h"
+#include "main.h"
+#include "journal.h"
+#include "battery.h"
+#include "sched.h"
+#include "icm20948.h"
+#include "ak09916.h"
+#include "channels.h"
+#include "config.h"
+#include "wom.h"
+#include "activity.h"
+#include "ahrs.h"
+#include "trigger.h"
+#include "sdcard.h"
+#include "logbuf.h"
+#include "cardinfo.h"
+#include "rotate.h"
 /*
 #define SW1 BIT0 //Port3
 #define SW2 BIT5 //Port1
@@ -26,6 +42,16 @@
 #define RTC_CS_SEL          P4SEL1
 #define RTC_CS_OUT          P4OUT
 #define RTC_CS_DIR          P4DIR
+#define RTC_SPI_BRW         (SMCLK_FREQUENCY / 2000000)  // 2 MHz, DS3234 allows 4 MHz
+
+#define DEBOUNCE_TICKS      655     // 20 ms of ACLK, button debounce/release poll interval
+#define LFXT_START_MS       1000    // crystal start-up allowed at boot, then ACLK stays on LFMODCLK
+
+#define SAMPLE_RING_LEN     8       // samples buffered between acquisition and disk task
+#define SAMPLE_RING_FLUSH   4       // post EVT_BUFFER_FULL at this fill level
+#define SD_BENCH_SECTORS    64      // sectors read by the boot throughput test
+#define SD_BENCH_XMIT       8       // sectors clocked out for the transmit cycle count
+#define MEM_BENCH_WORDS     256     // one sector, FRAM against SRAM access test
 
 #define MAX_BUFFER_SIZE     20
 #define DUMMY   0xFF
@@ -149,13 +175,27 @@ uint8_t TransmitIndex = 0;
 
 
 //SD card variables
-FATFS sdVolume;     // FatFs work area needed for each volume
+#pragma DATA_SECTION(sdVolume, ".fram_buffers")
+FATFS sdVolume;     // FatFs work area needed for each volume, sector window in FRAM
+#pragma DATA_SECTION(FfPool, ".fram_buffers")
+BYTE FfPool[_FS_BUFPOOL][_MAX_SS];  // sector buffers leased by the open files, see ffconf.h
+#pragma PERSISTENT(FfWinCache)
+FFWINCACHE FfWinCache = {0};        // FAT and directory sectors not on the card yet, see ffconf.h
+#pragma PERSISTENT(FfGeoCache)
+FFGEOCACHE FfGeoCache = {0};        // volume layout of the last card mounted, see ffconf.h
 FIL logfile;        // File object needed for each open file
+FIL actfile;        // epoch summaries, log=summary
+FIL evtfile;        // card errors and write path counters
 uint16_t fp;        // Used for sizeof
 uint8_t status = 17;    // SD card status variable that should change if successful
-unsigned int backupCtr = 0; // Counter for data backup
+unsigned int backupCtr = 0; // Counter for status LED
 unsigned int mode; // operating mode(standby mode / measurement mode)
 unsigned int measurementInit; //check if new file has to be created and opened
+char filename[] = "RAW_00.CSV";     // data file of the current session
+char batname[] = "BAT_00.CSV";      // supply voltage history of the current session
+char actname[] = "ACT_00.CSV";      // epoch summaries of the current session
+char evtname[] = "EVT_00.CSV";      // events of the current session
+volatile bool buttonHeld = false;   // debouncer is waiting for S1 to be released
 bool RTCnewer = false;
 
 int16_t comp_year = 7;
@@ -167,35 +207,28 @@ int16_t comp_second = 7;
 char testdate[10];
 char testtime[10];
 
-unsigned char RX_Data[23];
-unsigned char TX_Data[2];
-unsigned char RX_ByteCtr = 0;
-unsigned char TX_ByteCtr = 0;
-unsigned char slaveAddress = 0x69;  // Set slave address for ICM20948 0x68 for ADD pin=0/0x69 for ADD pin=1
 unsigned int G_MODE;
 unsigned int DPS_MODE;
 int sensorsetting = 0b0000; // DIPswitch position to control sensor mode(accel+gyro setting)
-int xAccel = 0;
-int yAccel = 0;
-int zAccel = 0;
-int xGyro = 0;
-int yGyro = 0;
-int zGyro = 0;
-int Temp = 0;
-int xMag = 0;
-int yMag = 0;
-int zMag = 0;
-int magstat1 = 0;
-int magstat2 = 0;
-int whoami = 0;
-int register_value = 0;
-int slave4done = 0;
-int count = 0;
-int a = 0;
-
-void i2cInit(void);
-void i2cWrite(unsigned char);
-void i2cRead(unsigned char);
+uint32_t sessionStart = 0;          // clock_ms() when the session file was opened
+bool sdErased = false;              // card erased where the next session file goes
+DWORD sdClockKHz = 0;               // SPI clock chosen for the card
+uint16_t sdMountMs = 0;             // time f_mount() took at boot
+uint16_t sdReadKBps = 0;            // measured read throughput, 0 = test failed
+uint32_t sdRxCycles = 0;            // MCLK cycles per sector read, command overhead included
+uint32_t sdTxCycles = 0;            // MCLK cycles per sector transmitted
+uint16_t framReadCycles = 0;        // MCLK cycles to read 512 bytes word by word from FRAM
+uint16_t framWriteCycles = 0;       // ... to write them
+uint16_t sramReadCycles = 0;        // same loops on SRAM
+uint16_t sramWriteCycles = 0;
+bool lfxtFailed = false;            // 32 kHz crystal did not start, ACLK runs on LFMODCLK
+
+// sample ring between acquisition task and disk task, kept in FRAM to spare SRAM
+#pragma PERSISTENT(sampleRing)
+sample_t sampleRing[SAMPLE_RING_LEN] = {0};
+uint8_t ringHead = 0;               // next slot written by taskAcquire
+uint8_t ringTail = 0;               // next slot written to the card by taskWrite
+uint16_t ringOverruns = 0;          // samples dropped because the ring was full
 
 //*********************************************************************************************
 //select sensitivity for sensors
@@ -216,52 +249,54 @@ static void RTC_DESELECT (void){
 }
 //*********************************************************************************************
 
-//helper function to initialize USCIB0 I2C
-void i2cInit(void)
+//helper function for RTC SPI data transfer
+void SendUCA1Data(uint8_t val)
 {
-
-    // Configure USCI_B0 for I2C mode
-     UCB0CTLW0 = UCSWRST;                      // put eUSCI_B in reset state
-     UCB0CTLW0 |= UCMODE_3 | UCMST | UCSSEL__SMCLK | UCSYNC; // I2C master mode, SMCLK
-     //UCB0BRW = 0x2;                            // baudrate = SMCLK / 2
-     //UCB0BRW = 0x50;                            // baudrate = SMCLK / 20 = ~400kHz
-     UCB0BRW = 20;                            // baudrate = SMCLK / 20 = ~400kHz
-     UCB0CTLW0 &= ~UCSWRST;                    // clear reset register
-     UCB0IE |= UCTXIE0 | UCNACKIE;             // transmit and NACK interrupt enable
+    while (!(UCA1IFG & UCTXIFG));              // USCI_A1 TX buffer ready?
+    UCA1TXBUF = val;
 }
-
 //*********************************************************************************************
-//helper function to access ICM20948 registers
-void i2cWrite(unsigned char address)
-{
-    __disable_interrupt();
-    UCB0I2CSA = address;                // Load slave address
-    UCB0IE |= UCTXIE;                   //Enable TX interrupt
-    while(UCB0CTL1 & UCTXSTP);          // Ensure stop condition sent
-    UCB0CTL1 |= UCTR + UCTXSTT;         // TX mode and START condition
-    __bis_SR_register(CPUOFF + GIE);    // sleep until UCB0RXIFG is set ...
-    //__bis_SR_register(GIE);    // sleep until UCB0TXIFG is set ...
-}
 
-//*********************************************************************************************
-// helper function to read ICM20948 registers
-void i2cRead(unsigned char address)
-{
-    __disable_interrupt();
-    UCB0I2CSA = address;                // Load slave address
-    UCB0IE |= UCRXIE;                   // Enable RX interrupt
-    while(UCB0CTL1 & UCTXSTP);          // Ensure stop condition sent
-    UCB0CTL1 &= ~UCTR;                  // RX mode
-    UCB0CTL1 |= UCTXSTT;                // Start Condition
-    __bis_SR_register(CPUOFF + GIE);    // sleep until UCB0RXIFG is set ...
-    //__bis_SR_register(GIE);    // sleep until UCB0RXIFG is set ...
+// USCI_A1 is shared with the SD card, which runs it polled at its own clock.
+// The RTC transfer saves that setup and puts it back when it is done.
+static uint16_t sdSpiCtlw0;
+static uint16_t sdSpiBrw;
+static uint16_t sdSpiIe;
+
+static void rtcSpiOpen(void){
+    //Port initialization for SPI operation
+    RTC_SPI_SEL |= RTC_SPI_CLK | RTC_SPI_SOMI | RTC_SPI_SIMO;
+    RTC_SPI_DIR |= RTC_SPI_CLK | RTC_SPI_SIMO;
+
+    RTC_CS_SEL &= ~RTC_CS;
+    RTC_CS_OUT |= RTC_CS;
+    RTC_CS_DIR |= RTC_CS;
+
+    RTC_SPI_REN |= RTC_SPI_SOMI | RTC_SPI_SIMO;
+    RTC_SPI_OUT |= RTC_SPI_SOMI | RTC_SPI_SIMO;
+
+    sdSpiCtlw0 = UCA1CTLW0;
+    sdSpiBrw = UCA1BRW;
+    sdSpiIe = UCA1IE;
+
+    //Initialize USCI_A1 for SPI Master operation
+    UCA1CTLW0 = UCSWRST;                           //Put state machine in reset
+    UCA1CTLW0 |= UCCKPL | UCMSB | UCMST | UCSYNC;  //3-pin, 8-bit SPI master
+                                                   //Clock polarity select - The inactive state is high
+    UCA1CTLW0 |= UCSSEL_2;                         //Use SMCLK, keep RESET
+    UCA1BRW = RTC_SPI_BRW;
+    UCA1CTLW0 &= ~UCSWRST;                         //Release USCI state machine
+    UCA1IFG &= ~UCRXIFG;
+    UCA1IE |= UCRXIE;                              // Enable USCI_A1 RX interrupt
 }
 //*********************************************************************************************
-//helper function for RTC SPI data transfer
-void SendUCA1Data(uint8_t val)
-{
-    while (!(UCA1IFG & UCTXIFG));              // USCI_A1 TX buffer ready?
-    UCA1TXBUF = val;
+
+static void rtcSpiClose(void){
+    UCA1CTLW0 = sdSpiCtlw0 | UCSWRST;
+    UCA1BRW = sdSpiBrw;
+    UCA1CTLW0 = sdSpiCtlw0;
+    UCA1IFG &= ~UCRXIFG;
+    UCA1IE = sdSpiIe;
 }
 //*********************************************************************************************
 
@@ -290,28 +325,7 @@ void CopyArray(uint8_t *source, uint8_t *dest, uint8_t count)
  *  */
 SPI_Mode SPI_Master_WriteReg(uint8_t reg_addr, uint8_t *reg_data, uint8_t count)
 {
-    //Port initialization for SPI operation
-        RTC_SPI_SEL |= RTC_SPI_CLK | RTC_SPI_SOMI | RTC_SPI_SIMO;
-        RTC_SPI_DIR |= RTC_SPI_CLK | RTC_SPI_SIMO;
-
-        RTC_CS_SEL &= ~RTC_CS;
-        RTC_CS_OUT |= RTC_CS;
-        RTC_CS_DIR |= RTC_CS;
-
-        RTC_SPI_REN |= RTC_SPI_SOMI | RTC_SPI_SIMO;
-        RTC_SPI_OUT |= RTC_SPI_SOMI | RTC_SPI_SIMO;
-
-        //Initialize USCI_A1 for SPI Master operation
-        UCA1CTLW0 = UCSWRST;                           //Put state machine in reset
-        UCA1CTLW0 |= UCCKPL | UCMSB | UCMST | UCSYNC;  //3-pin, 8-bit SPI master
-                                                       //Clock polarity select - The inactive state is high
-        UCA1CTLW0 |= UCSSEL_2;                         //Use SMCLK, keep RESET
-        UCA1BR0 = 3;                                   //Initial SPI clock must be <400kHz
-        UCA1BR1 = 0;                                   //f_UCxCLK = 1MHz/(3+1) = 250kHz
-        //UCA1BRW = 25;
-        UCA1CTLW0 &= ~UCSWRST;                         //Release USCI state machine
-        UCA1IFG &= ~UCRXIFG;
-        UCA1IE |= UCRXIE;                              // Enable USCI_A1 RX interrupt
+    rtcSpiOpen();
 
     MasterMode = TX_REG_ADDRESS_MODE;
     TransmitRegAddr = reg_addr | 0x80;              //writable RTC registers start with 0x80
@@ -321,39 +335,23 @@ SPI_Mode SPI_Master_WriteReg(uint8_t reg_addr, uint8_t *reg_data, uint8_t count)
     ReceiveIndex = 0;
     TransmitIndex = 0;
     RTC_SELECT();
+    __disable_interrupt();
     SendUCA1Data(TransmitRegAddr);
-
-    __bis_SR_register(CPUOFF + GIE);                // Enter LPM0 w/ interrupts
+    while(MasterMode != IDLE_MODE){
+        __bis_SR_register(CPUOFF + GIE);            // Enter LPM0 w/ interrupts
+        __disable_interrupt();
+    }
+    __enable_interrupt();
 
     RTC_DESELECT();
+    rtcSpiClose();
     return MasterMode;
 }
 //*********************************************************************************************
 
 SPI_Mode SPI_Master_ReadReg(uint8_t reg_addr, uint8_t count)
 {
-    //Port initialization for SPI operation
-        RTC_SPI_SEL |= RTC_SPI_CLK | RTC_SPI_SOMI | RTC_SPI_SIMO;
-        RTC_SPI_DIR |= RTC_SPI_CLK | RTC_SPI_SIMO;
-
-        RTC_CS_SEL &= ~RTC_CS;
-        RTC_CS_OUT |= RTC_CS;
-        RTC_CS_DIR |= RTC_CS;
-
-        RTC_SPI_REN |= RTC_SPI_SOMI | RTC_SPI_SIMO;
-        RTC_SPI_OUT |= RTC_SPI_SOMI | RTC_SPI_SIMO;
-
-        //Initialize USCI_A1 for SPI Master operation
-        UCA1CTLW0 = UCSWRST;                                //Put state machine in reset
-        UCA1CTLW0 |= UCCKPL | UCMSB | UCMST | UCSYNC;       //3-pin, 8-bit SPI master
-                                                            //Clock polarity select - The inactive state is high
-        UCA1CTLW0 |= UCSSEL_2;                              //Use SMCLK, keep RESET
-        UCA1BR0 = 3;                                        //Initial SPI clock must be <400kHz
-        UCA1BR1 = 0;                                        //f_UCxCLK = 1MHz/(3+1) = 250kHz
-        //UCA1BRW = 25;
-        UCA1CTLW0 &= ~UCSWRST;                              //Release USCI state machine
-        UCA1IFG &= ~UCRXIFG;
-        UCA1IE |= UCRXIE;                                   // Enable USCI_A1 RX interrupt
+    rtcSpiOpen();
 
     MasterMode = TX_REG_ADDRESS_MODE;
     TransmitRegAddr = reg_addr;
@@ -362,9 +360,15 @@ SPI_Mode SPI_Master_ReadReg(uint8_t reg_addr, uint8_t count)
     ReceiveIndex = 0;
     TransmitIndex = 0;
     RTC_SELECT();
+    __disable_interrupt();
     SendUCA1Data(TransmitRegAddr);
-    __bis_SR_register(CPUOFF + GIE);              // Enter LPM0 w/ interrupts
+    while(MasterMode != IDLE_MODE){
+        __bis_SR_register(CPUOFF + GIE);          // Enter LPM0 w/ interrupts
+        __disable_interrupt();
+    }
+    __enable_interrupt();
     RTC_DESELECT();
+    rtcSpiClose();
     return MasterMode;
 }
 //*********************************************************************************************
@@ -636,7 +640,7 @@ void checkDIPswitch(){
             while(1){                       //DIP switch position could not be read -> blinking leds
                 P1OUT ^= BIT0;
                 P4OUT ^= BIT6;
-                _delay_cycles(500000);
+                __delay_cycles(MCLK_FREQUENCY / 16);
             }
     }
 
@@ -675,13 +679,421 @@ void checkDIPswitch(){
             DPS_MODE = 0b00000000;
             break;
     }
+    icmAccelConfig = G_MODE;
+    icmGyroConfig = DPS_MODE;
+}
+
+//*********************************************************************************************
+//time the sector loops at the negotiated SPI clock, reported in the session header.
+//Timer0_B counts SMCLK / 8, so it needs sched_init() first.
+void sdBenchmark(void){
+    DWORD arg[2];
+    uint32_t t;
+    uint8_t i;
+
+    disk_ioctl(0, MMC_GET_SPEED, &sdClockKHz);
+    arg[0] = sdVolume.database;     //start of the data area exists on every volume
+    arg[1] = SD_BENCH_SECTORS;
+    t = sched_now();
+    if(disk_ioctl(0, MMC_READ_TEST, arg) == RES_OK){
+        t = sched_now() - t;
+        sdRxCycles = t * 8 / SD_BENCH_SECTORS;
+        sdReadKBps = (uint16_t)((uint32_t)SD_BENCH_SECTORS * 512 * (SMCLK_FREQUENCY / 8000) / (t ? t : 1));
+    }
+
+    //window contents do not matter, the card is deselected
+    t = sched_now();
+    for(i = 0; i < SD_BENCH_XMIT; i++){
+        disk_ioctl(0, MMC_XMIT_TEST, sdVolume.win);
+    }
+    sdTxCycles = (sched_now() - t) * 8 / SD_BENCH_XMIT;
+}
+
+//*********************************************************************************************
+//the word loops of memBenchmark(), p[i & mask] keeps the code the same for both memories
+static uint16_t memRead(const volatile uint16_t *p, uint16_t mask){
+    uint16_t i, sum = 0;
+
+    for(i = 0; i < MEM_BENCH_WORDS; i++){
+        sum += p[i & mask];
+    }
+    return sum;
+}
+
+static void memWrite(volatile uint16_t *p, uint16_t mask){
+    uint16_t i;
+
+    for(i = 0; i < MEM_BENCH_WORDS; i++){
+        p[i & mask] = i;
+    }
+}
+
+//*********************************************************************************************
+//cost of a sector buffer in FRAM, reported in the session header. FRAM needs a wait
+//state above 8 MHz, the cache hides it for part of the reads. There is no spare sector
+//of SRAM, so the SRAM loops walk 16 words on the stack. No file is open at boot, so the
+//pool buffers are free; the volume window is not touched, it caches a FAT sector.
+void memBenchmark(void){
+    uint16_t ram[16];
+    volatile uint16_t *fram = (volatile uint16_t *)FfPool[0];
+    uint32_t t;
+
+    t = sched_now();
+    memRead(fram, MEM_BENCH_WORDS - 1);
+    framReadCycles = (uint16_t)((sched_now() - t) * 8);
+    t = sched_now();
+    memWrite(fram, MEM_BENCH_WORDS - 1);
+    framWriteCycles = (uint16_t)((sched_now() - t) * 8);
+    t = sched_now();
+    memRead(ram, 15);
+    sramReadCycles = (uint16_t)((sched_now() - t) * 8);
+    t = sched_now();
+    memWrite(ram, 15);
+    sramWriteCycles = (uint16_t)((sched_now() - t) * 8);
+}
+
+//*********************************************************************************************
+//open a file of the session next to RAW_xx.CSV for appending. Its lines go out with
+//f_printf and f_sync, the sector buffer comes from the pool and is shared with logfile.
+static void openSessionFile(FIL *fp, char *name){
+    name[4] = filename[4];
+    name[5] = filename[5];
+    if(f_open(fp, name, FA_WRITE | FA_OPEN_ALWAYS) == FR_OK){
+        f_lseek(fp, fp->fsize);
+    }
+}
+
+//*********************************************************************************************
+//task accounting of the session, one line per task that ran:
+//sched,<task>,<runs>,<busy ms>,<worst MCLK cycles>, then ring,<samples dropped> and the
+//ICM20948 bus traffic, icm,<transfers>,<bank selects saved>,<reads saved>,<writes saved>,
+//and with the 'q' channel the filter cost, ahrs,<updates>,<mean MCLK cycles>,<worst MCLK cycles>
+static const char * const taskNames[SCHED_EVENTS] = {"battery", "button", "write", "sensor", "mag", "rtc"};
+
+static void writeSessionStats(FIL *fp){
+    uint8_t evt;
+
+    for(evt = 0; evt < SCHED_EVENTS; evt++){
+        if(schedStats[evt].runs){
+            f_printf(fp, "%s,%s,%lu,%lu,%lu\n", "sched", taskNames[evt], schedStats[evt].runs,
+                     (uint32_t)(schedStats[evt].ticks / (SMCLK_FREQUENCY / 8000)), schedStats[evt].worst * 8);
+        }
+    }
+    f_printf(fp, "%s,%u\n", "ring", ringOverruns);
+    f_printf(fp, "%s,%lu,%lu,%lu,%lu\n", "icm", icmStats.transfers, icmStats.bankSaved, icmStats.readsSaved, icmStats.writesSaved);
+    if(ahrsUpdates){
+        f_printf(fp, "%s,%lu,%lu,%lu\n", "ahrs", ahrsUpdates, (uint32_t)(ahrsTotal / ahrsUpdates), ahrsWorst);
+    }
+}
+
+//*********************************************************************************************
+//close the session files and write the voltage history next to them
+void stopMeasurement(void){
+    if(mode != 2){
+        return;                     //already ended by a card failover
+    }
+    P1OUT |= BIT0;                  //LED2 on = standby
+    mode = 1;                       //switch to standby mode
+    while(trigger_write(&logfile));     //rest of a running burst
+    logbuf_flush(&logfile);         //last partial sector
+    rotate_stop(&logfile);          //drop the part prepared ahead, list the last one in MAN_xx.CSV
+    journal_close(&logfile);        //Trim the reserved extent and close the file
+    logbuf_write_stats(&evtfile);   //write path counters of the session
+    writeSessionStats(&evtfile);    //task run times, ring overruns, bus traffic and filter cost of the session
+    f_close(&evtfile);
+    f_close(&actfile);              //not open without log=summary
+    batname[4] = filename[4];
+    batname[5] = filename[5];
+    battery_log_write(&logfile, batname);
+    f_flush("");                    //cached FAT and directory sectors, the card may be pulled now
+    measurementInit = 0;            //reset value to open new file for the next measurement
+    womSession = false;             //WOM standby is re-armed by taskTick
+}
+
+
+//*********************************************************************************************
+//measurement init phase = check DIP switch position, get current time, creating file, opening file
+void startMeasurement(void){
+    FILINFO fno;
+    FRESULT fr;
+    uint8_t i;
+
+    icm_clear_stats();              //the trailer of EVT_xx.CSV counts the bus traffic of this session
+
+    //leave WOM standby, gyro needs to be running before the first sample
+    wom_wake();
+
+    //magnetometer state is final before the header and the channel layout
+    ak_finish();
+
+    //check switch setting for accel+gyro modes
+    checkDIPswitch();
+
+    icm_apply(icmRangeTable, icmRangeTableLen);
+
+    //channel set from CONFIG.TXT or FRAM, sizes the burst read and the record
+    config_load(&logfile);
+    channels_layout((activitySummary || womThresholdMg ? CH_ACCEL : 0) | trigger_channels());   //read even if not logged
+    activity_start(AccelSensitivity);
+    wom_start(AccelSensitivity);
+    trigger_start(AccelSensitivity, GyroSensitivity);
+    ahrs_start(GyroSensitivity);
+
+    DS3234GetCurrentTime();
+
+    for(i = 0; i < 100; i++){
+        filename[4] = i / 10 + '0';
+        filename[5] = i % 10 + '0';
+        fr = f_stat(filename, &fno);
+            if(fr == FR_OK){
+                continue;
+            }
+            else if(fr == FR_NO_FILE){
+                    break;
+            }
+            else{
+                // Error occurred
+                P4OUT |= BIT6;
+                P1OUT |= BIT0;
+                while(1);
+            }
+    }
+
+    if(f_open(&logfile, filename, FA_WRITE | FA_OPEN_ALWAYS | FA_ALIGN) == FR_OK) {    // Open file - If nonexistent, create, on free AUs of the card
+        f_lseek(&logfile, logfile.fsize);           // Move forward by filesize; logfile.fsize+1 is not needed in this application
+        journal_open(&logfile, filename);           // pre-allocate extent, start FRAM commit record
+    }
+    logbuf_open(&logfile);                          // records go through the FRAM sector block from here
+    openSessionFile(&evtfile, evtname);
+    if(activitySummary){
+        openSessionFile(&actfile, actname);
+    }
+    battery_log_start();
+    logbuf_printf(&logfile, "%s,%d,%s,%d,%s,%d,%s,%d,%s,%d,%s,%d,%s,%d\n","weekday: ",TimeArray[3],"//date: ",TimeArray[4],".",TimeArray[5],".",TimeArray[6],"//time: ",TimeArray[2],":",TimeArray[1],":",TimeArray[0]);
+    logbuf_printf(&logfile, "%d,%s,%d,%s,%s,%s,%s,%lu,%s,%u,%s,%lu,%s,%lu,%s,%s,%u,%u,%s,%u,%u,%s,%s,%u,%s,%s,%s\n",AccelSensitivity,"g",GyroSensitivity,"dps","mag",ak_health_name(),
+             "sd",sdClockKHz,"kHz",sdReadKBps,"kB/s",sdRxCycles,"cyc_rx",sdTxCycles,"cyc_tx",
+             "fram",framReadCycles,framWriteCycles,"sram",sramReadCycles,sramWriteCycles,"cyc_512","mount",sdMountMs,"ms","aclk",lfxtFailed ? "lfmod" : "lfxt");
+    if(activity_raw(0) || trigger_enabled()){
+        channels_write_header(&logfile);
+    }
+    sessionStart = clock_ms();
+    rotate_start(filename);                         // first part of the session file
+    sdErased = false;                               // the session writes into the erased AUs
+
+    ringHead = 0;
+    ringTail = 0;
+    ringOverruns = 0;
+    sched_clear();                                  // the trailer of EVT_xx.CSV covers this session
+    measurementInit++;
+}
+
+
+//*********************************************************************************************
+//Tasks run by the scheduler, see sched.h for the priority order
+void taskWrite(void);
+
+
+//supply is sagging: close the file while the card still accepts writes
+void taskLowBattery(void){
+    if(mode == 2){
+        taskWrite();                        //samples still in the ring go out first
+        stopMeasurement();
+    }
+    P4OUT |= BIT6;                          // LED1 on = battery low
+}
+
+//switch to measurement mode and start sampling
+void beginSession(void){
+    P1OUT &= ~BIT0;                         //LED2 off
+    P4OUT &= ~BIT6;                         //LED1 off
+    mode = 2;                               //switch to measurement mode
+    startMeasurement();
+    sched_post(EVT_SENSOR_READY);
+}
+
+//card error while writing: recover the session file or end the session without the card
+void sdFault(void){
+    sd_recover_t how = sd_recover(&sdVolume, &logfile);
+
+    if(how != SD_RECOVER_FAILED){
+        if(how == SD_RECOVER_REMOUNT){      //the other files went stale with the old mount
+            rotate_lost();
+            openSessionFile(&evtfile, evtname);
+            if(activitySummary){
+                openSessionFile(&actfile, actname);
+            }
+        }
+        //lines around the error may be lost, note the time and the stall
+        f_printf(&evtfile, "%s,%lu,%s,%lu\n", "sd_error", clock_ms() - sessionStart, sd_recover_name(how), sdStats.lastMs);
+        f_sync(&evtfile);
+        return;
+    }
+    //failover: the journal record stays open, the file is trimmed once the card is back
+    mode = 1;
+    measurementInit = 0;
+    womSession = false;
+    P4OUT |= BIT6;                          //LED1 + LED2 on = card error
+    P1OUT |= BIT0;
+}
+
+//debounced button press: start or stop a session at a safe point between samples
+void taskButton(void){
+    if(mode == 1){
+        if(!batteryLow && !sdFailed){       //do not start a session on a sagging supply or without card
+            beginSession();
+        }
+    }
+    else if(mode == 2){
+        taskWrite();
+        stopMeasurement();
+    }
+}
+
+//writing data to file
+void taskWrite(void){
+    sample_t *smp;
+    FRESULT fr;
+
+    while(ringTail != ringHead && !logfile.err){
+        smp = &sampleRing[ringTail];
+        channels_write_sample(&logfile, smp);
+        ringTail = (ringTail + 1) % SAMPLE_RING_LEN;
+
+        backupCtr++;
+        if(backupCtr == 250){
+            P1OUT ^= BIT0;
+            backupCtr = 0;
+        }
+    }
+
+    if(activityEpochReady){
+        activity_write_epoch(&actfile);
+        f_sync(&actfile);                   //one line per epoch, keep it across a power loss
+    }
+    trigger_write(&logfile);                //one chunk, taskAcquire posts again while lines are left
+
+    //go on in the next part of the session file, normally created ahead by taskTick
+    if(!logfile.err && rotate_due(&logfile)){
+        fr = rotate_switch(&logfile);
+        if(fr == FR_DISK_ERR || fr == FR_NOT_READY){
+            sdFault();
+            return;
+        }
+        if(fr == FR_OK && (activity_raw(clock_ms() - sessionStart) || trigger_enabled())){
+            channels_write_header(&logfile);    //every part can be read on its own
+        }
+    }
+
+    //commit written sectors to FRAM, replaces the f_sync every 5000 samples
+    fr = journal_commit(&logfile);
+    if(logfile.err || fr == FR_DISK_ERR || fr == FR_NOT_READY){
+        sdFault();
+    }
+}
+
+//read one sample into the ring
+void taskAcquire(void){
+    uint8_t next;
+    sample_t *smp;
+    bool keep;
+
+    if(mode != 2){
+        return;
+    }
+
+    // burst over the selected channels only
+    if(channelBurstLen){
+        icm_read_burst(0, channelBurstReg, channelBurstLen);
+    }
+
+    smp = &sampleRing[ringHead];            //the head slot is free even when the ring is full
+    channels_parse(smp, clock_ms() - sessionStart);
+    if(channelMask & CH_QUAT){
+        ahrs_update(smp);
+    }
+    activity_feed(smp);
+    if(womSession){
+        wom_feed(smp);                      //inactivity that closes the session
+    }
+    if(activityEpochReady){
+        sched_post(EVT_BUFFER_FULL);
+    }
+
+    //burst mode: the trigger ring keeps every sample, only the slow rate goes through the ring here
+    keep = trigger_enabled() ? trigger_feed(smp) : activity_raw(smp->time);
+    if(trigger_backlog()){
+        sched_post(EVT_BUFFER_FULL);
+    }
+
+    if(keep){
+        next = (ringHead + 1) % SAMPLE_RING_LEN;
+        if(next == ringTail){
+            ringOverruns++;
+        }
+        else{
+            ringHead = next;
+        }
+    }
+    if((uint8_t)(ringHead - ringTail) % SAMPLE_RING_LEN >= SAMPLE_RING_FLUSH){
+        sched_post(EVT_BUFFER_FULL);
+    }
+    sched_post(EVT_SENSOR_READY);           //sample back to back, like the old while(1)
 }
 
+//1 Hz housekeeping
+void taskTick(void){
+    if(mode == 1 && !batteryLow && !sdFailed){
+        P4OUT &= ~BIT6;                     // supply recovered
+    }
+    if(sdFailed && sd_retry_tick(&sdVolume, &logfile)){
+        P4OUT &= ~BIT6;                     // card is back, sessions can start again
+    }
+
+    //erase the first extent of the next session file ahead, its writes then skip the card's own erase
+    if(mode == 1 && !sdErased && !batteryLow && !sdFailed){
+        f_preerase("", JOURNAL_RESERVE);    //not every card can, the session works without it
+        sdErased = true;
+    }
+
+    //next part of a rotated session file, in the background of the sampling
+    if(mode == 2 && !sdFailed){
+        rotate_tick(&logfile);
+    }
+
+    //auto-record: WOM standby while idle, open a session on motion, close it when still
+    if(mode == 1 && womThresholdMg && !batteryLow && !sdFailed && akHealth != AK_HEALTH_STARTING){
+        if(!womArmed){
+            wom_standby();                  //after the mag bring-up, SLV4 is too slow when duty cycled
+        }
+        else if(wom_motion()){
+            beginSession();
+            womSession = true;
+        }
+    }
+    else if(mode == 2 && womSession){
+        if(wom_idle_tick()){
+            taskWrite();
+            stopMeasurement();
+        }
+    }
+}
+
+const sched_handler_t tasks[SCHED_EVENTS] = {
+    taskLowBattery,                         // EVT_LOW_BATTERY
+    taskButton,                             // EVT_BUTTON
+    taskWrite,                              // EVT_BUFFER_FULL
+    taskAcquire,                            // EVT_SENSOR_READY
+    ak_poll,                                // EVT_MAG_TICK
+    taskTick                                // EVT_RTC_TICK
+};
 
 
 //*********************************************************************************************
 //*********************************************************************************************
 int main(void){
+      uint32_t mountStart;
+      uint16_t i;
+      FRESULT fr;
 
       WDTCTL = WDTPW | WDTHOLD;       // Stop WDT
 
@@ -704,6 +1116,7 @@ int main(void){
       P3DIR &= ~BIT0;                           //set P3.0 to input DIPSWITCH
 
       P1SEL1 |= BIT6 + BIT7;                    //for I2C functionality P1SEL1 high,P1SEL0 low
+      PJSEL0 |= BIT4 | BIT5;                    //PJ.4, PJ.5 to the 32768 Hz crystal (LFXIN, LFXOUT)
       //P1SEL0|= BIT6 + BIT7;                   //for I2C functionality P1SEL1 high,P1SEL0 low
 
       // Disable the GPIO power-on default high-impedance mode to activate
@@ -713,43 +1126,46 @@ int main(void){
       P4IE |= BIT5;               //Enable P4.5 IRQ (Switch1)
       P4IFG &= ~BIT5;             //clear flag
 
+      // Timer0_A: one-shot button debouncer on ACLK, started by the P4.5 ISR
+      TA0CCR0 = DEBOUNCE_TICKS;
+      TA0CCTL0 = CCIE;
+
 
 
 //--------------------------------------CLOCK Config----------------------------------------------------------------------------
 
-/*
-      //set clock to 16MHz
+      //set clock to 16MHz (MCLK_FREQUENCY)
       // Configure one FRAM waitstate as required by the device datasheet for MCLK
       // operation beyond 8MHz _before_ configuring the clock system.
       FRCTL0 = FRCTLPW | NWAITS_1;
 
-      // Clock System Setup
-      CSCTL0_H = CSKEY_H;                    // Unlock CS registers
-      CSCTL1 = DCOFSEL_0;             // Set DCO to 1MHz
-      CSCTL2 = SELA__LFXTCLK | SELS__DCOCLK | SELM__DCOCLK;
-      CSCTL3 = DIVA__4 | DIVS__4 | DIVM__4;     // Set all dividers
-      CSCTL1 = DCORSEL | DCOFSEL_4;             // Set DCO to 16MHz
-
-      __delay_cycles(60);
-      CSCTL3 = DIVA__1 | DIVS__1 | DIVM__1;     // Set all dividers
-      CSCTL0_H = 0;                             // Lock CS registers
-
-
-      //set clock to 8MHz
       CSCTL0_H = CSKEY >> 8;                    // Unlock CS registers
-      CSCTL1 = DCOFSEL_6;                       // Set DCO to 8MHz
-      CSCTL2 = SELA__VLOCLK | SELS__DCOCLK | SELM__DCOCLK; // Set ACLK = LFXTCLK; SMCLK = MCLK = DCO
-      CSCTL3 = DIVA__1 | DIVS__1 | DIVM__1;     // Set all dividers to 1
-      CSCTL0_H = 0;                             // Lock CS registers
-*/
-      //set clock to 8MHz
-      CSCTL0_H = CSKEY >> 8;                    // Unlock CS registers
-      CSCTL1 = DCOFSEL_6;                       // Set DCO to 8MHz
+      CSCTL1 = DCOFSEL_0;                       // Set DCO to 1MHz
       CSCTL2 = SELA__LFXTCLK | SELS__DCOCLK | SELM__DCOCLK; // Set ACLK = LFXTCLK; SMCLK = MCLK = DCO
+      CSCTL3 = DIVA__1 | DIVS__4 | DIVM__4;     // Divide by 4 while the DCO settles (erratum CS12)
+      CSCTL1 = DCORSEL | DCOFSEL_4;             // Set DCO to 16MHz
+      __delay_cycles(60);
       CSCTL3 = DIVA__1 | DIVS__1 | DIVM__1;     // Set all dividers to 1
       CSCTL4 &= ~LFXTOFF;                       // Turn on LFXT
+      for(i = 0; i < LFXT_START_MS; i++){       // a missing or cracked crystal must not stop the boot
+          CSCTL5 &= ~LFXTOFFG;                  // Clear the LFXT fault until the crystal runs,
+          SFRIFG1 &= ~OFIFG;                    // ACLK is LFMODCLK (about 14% off) meanwhile
+          if(!(SFRIFG1 & OFIFG)){
+              break;
+          }
+          __delay_cycles(MCLK_FREQUENCY / 1000);
+      }
+      if(SFRIFG1 & OFIFG){
+          CSCTL2 = SELA__LFMODCLK | SELS__DCOCLK | SELM__DCOCLK;    // keep the fallback on purpose
+          CSCTL4 |= LFXTOFF;
+          CSCTL5 &= ~LFXTOFFG;
+          SFRIFG1 &= ~OFIFG;
+          lfxtFailed = true;                    // reported in the session header
+      }
       CSCTL0_H = 0;                             // Lock CS registers
 
+      // Supply voltage monitoring, 1 Hz
+      battery_init();
 
       // Initialize the I2C state machine
       i2cInit();
@@ -772,8 +1188,14 @@ int main(void){
 //--------------------------------------Initialize SD card--------------------------------------------------------------------------------------------
 
 
-        // Mount the SD Card
-        switch( f_mount(&sdVolume, "", 0) ){
+        // card timeouts from FRAM, CONFIG.TXT can change them below
+        sd_init();
+
+        // Mount the SD Card now, the volume layout comes from FRAM if the card was mounted before
+        mountStart = clock_ms();
+        fr = f_mount(&sdVolume, "", 1);
+        sdMountMs = (uint16_t)(clock_ms() - mountStart);
+        switch(fr){
             case FR_OK:
                 status = 42;
                 break;
@@ -800,506 +1222,32 @@ int main(void){
             while(1);
         }
 
+        // repair the file of a session that was cut off by power loss
+        journal_recover(&logfile);
+        f_flush("");
 
-//--------------------------------------Initialize ICM20948--------------------------------------------------------------------------------------------
-
-      // Wake up the ICM20948
-      TX_Data[1] = 0x06;                      // address of PWR_MGMT_1 register
-      TX_Data[0] = 0b00000000;                // set register to zero (wakes up the ICM20948) and low power off
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      _delay_cycles(20000);
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00000000;                // BANK 0
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[1] = 0x06;                      // address of PWR_MGMT_1 register
-      TX_Data[0] = 0b10000000;                // ICM20948 RESET
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      _delay_cycles(800000);
-
-      // Wake up the ICM20948
-      TX_Data[1] = 0x06;                      // address of PWR_MGMT_1 register
-      TX_Data[0] = 0b00000001;                //BIT6=0(wake up),BIT5=0(low power disable),BIT[2:0]=001(autoselect best clock)
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      _delay_cycles(80000);
-
-      TX_Data[1] = 0x05;                      // address of LP_CONFIG register
-      TX_Data[0] = 0b01000000;                // set ACCEL/GYRO/I2CMST to continuous
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      //check switch setting for accel+gyro modes
-      checkDIPswitch();
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00100000;                // Select BANK 2
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[1] = 0x14;                      // address of ACCEL_CONFIG_1 register
-      TX_Data[0] = G_MODE;                    // switch to selected accel mode
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00100000;                // Select BANK 2
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[1] = 0x01;                      // address of GYRO_CONFIG_1 register
-      TX_Data[0] = DPS_MODE;                  // switch to selected gyro mode
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-//----------------------------------magnetometer config-----------------------------------------------------------------------
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00000000;                // Select BANK 0
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[0] = 0x0F;                        // address of INT_PIN_CFG register
-      TX_ByteCtr = 1;
-      i2cWrite(slaveAddress);
-
-      RX_ByteCtr = 2;
-      i2cRead(slaveAddress);
-      register_value = RX_Data[1];
-      register_value &= ~(1<<1);              // clear BYPASS_EN BIT to deactivate I2C passthrough mode
-
-      TX_Data[1] = 0x0F;                      // address of INT_PIN_CFG register
-      TX_Data[0] = register_value;
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00110000;                // Select BANK 3
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[0] = 0x01;                        // address of I2C_MST_CTRL register
-      TX_ByteCtr = 1;
-      i2cWrite(slaveAddress);
-
-      RX_ByteCtr = 2;
-      i2cRead(slaveAddress);
-      register_value = RX_Data[1];
-      register_value &= ~(0x0F);                 //clear bits for master clock [3:0]
-      register_value |= (0x07);                  //set bits for master clock [3:0], 0x07 corresponds to 345.6 kHz, good for up to 400 kHz
-      register_value |= (1<<4);                  //set bit [4] for NSR (next slave read). 0 = restart between reads. 1 = stop between reads.
-
-      TX_Data[1] = 0x01;                      // address of I2C_MST_CTRL register
-      TX_Data[0] = register_value;
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00000000;                // Select BANK 0
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      TX_Data[0] = 0x03;                        // address of USER_CTRL register
-      TX_ByteCtr = 1;
-      i2cWrite(slaveAddress);
-
-      RX_ByteCtr = 2;
-      i2cRead(slaveAddress);
-      register_value = RX_Data[1];
-      register_value |= (1<<5);                // set BIT[5] to enable I2C master
-
-      TX_Data[1] = 0x03;                      // address of USER_CTRL register
-      TX_Data[0] = register_value;
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
-
-      //Configure magnetometer as I2C Slave
-      //for readMag: addr=0x80 | address
-      //for writeMag:addr=0x00 | address
-      for(a=0;a<5;a++){
-          TX_Data[1] = 0x7F;                      // address of BANK SEL register
-          TX_Data[0] = 0b00110000;                // Select BANK 3
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          TX_Data[1] = 0x13;                      // address of I2C_SLV4_ADDR register
-          TX_Data[0] = 0b10001100;                // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          TX_Data[1] = 0x14;                      // address of I2C_SLV4_REG register
-          TX_Data[0] = 0b00000000;                // BIT[7:0] to register address 0x00 WIA1
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          TX_Data[1] = 0x15;                      // address of I2C_SLV4_CTRL register
-          TX_Data[0] = 0b10000000;                // EN bit enable, rest disabled
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-
-          TX_Data[1] = 0x7F;                      // address of BANK SEL register
-          TX_Data[0] = 0b00000000;                // Select BANK 0
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          slave4done = 0;
-          while(slave4done == 0){
-              TX_Data[0] = 0x17;                        // address of I2C_MST_STATUS register
-              TX_ByteCtr = 1;
-              i2cWrite(slaveAddress);
-
-              RX_ByteCtr = 2;
-              i2cRead(slaveAddress);
-              register_value = RX_Data[1];
-
-              if(register_value & (1<<6)){
-                  slave4done = 2;
-              }
-              else{
-                 count++;
-                 if(count == 1000){
-                     slave4done = 1;
-                     count = 0;
-                 }
-              }
-          }
-
-          TX_Data[1] = 0x7F;                      // address of BANK SEL register
-          TX_Data[0] = 0b00110000;                // Select BANK 3
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          TX_Data[0] = 0x17;                        // address of I2C_SLV4_DI register
-          TX_ByteCtr = 1;
-          i2cWrite(slaveAddress);
-
-          RX_ByteCtr = 2;
-          i2cRead(slaveAddress);            //MagWhoIAm1: register_value== 48h?
-          whoami = RX_Data[1];              //MagWhoIAm2: register_value== 09h?
-          if(whoami != 0){
-              a = a + 6;                    //Mag seems to work --> exit reset loop
-                                            //+6 to debug loop counter
-          }
+        // auto-record settings, CONFIG.TXT is read again at every session start
+        config_load(&logfile);
 
 
-          //reset I2C Master
-          TX_Data[1] = 0x7F;                      // address of BANK SEL register
-          TX_Data[0] = 0b00000000;                // Select BANK 0
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-
-          TX_Data[0] = 0x03;                        // address of USER_CTRL register
-          TX_ByteCtr = 1;
-          i2cWrite(slaveAddress);
-
-          RX_ByteCtr = 2;
-          i2cRead(slaveAddress);
-          register_value = RX_Data[1];
-          register_value |= (1<<1);
-
-          TX_Data[1] = 0x03;                      // address of USER_CTRL register
-          TX_Data[0] = register_value;
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-          _delay_cycles(50000);
-
-          TX_Data[0] = 0x03;                        // address of USER_CTRL register
-          TX_ByteCtr = 1;
-          i2cWrite(slaveAddress);
-
-          RX_ByteCtr = 2;
-          i2cRead(slaveAddress);
-          register_value = RX_Data[1];
-          register_value |= (1<<5);                // set BIT[5] to enable I2C master
-
-          TX_Data[1] = 0x03;                      // address of USER_CTRL register
-          TX_Data[0] = register_value;
-          TX_ByteCtr = 2;
-          i2cWrite(slaveAddress);
-      }
-
-      if(a == 5 && whoami == 0){
-          while(1){
-              P4OUT ^= BIT6;
-              _delay_cycles(500000);
-          }
-      }
-
-
-      //switch Mag to Mode4: 100Hz continuous measurement
-        TX_Data[1] = 0x7F;                      // address of BANK SEL register
-        TX_Data[0] = 0b00110000;                // Select BANK 3
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x13;                      // address of I2C_SLV4_ADDR register
-        TX_Data[0] = 0b00001100;                // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x14;                      // address of I2C_SLV4_REG register
-        TX_Data[0] = 0b00110001;                // BIT[7:0] to register address 0x31 -->AK09916_REG_CNTL2
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x16;                      // address of I2C_SLV4_DO register
-        TX_Data[0] = 0b00001000;                // BIT[7:0] to mode 4: 100Hz continuous measurement
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x15;                      // address of I2C_SLV4_CTRL register
-        TX_Data[0] = 0b10000000;                // EN bit enable, rest disabled
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-
-        TX_Data[1] = 0x7F;                      // address of BANK SEL register
-        TX_Data[0] = 0b00000000;                // Select BANK 0
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        slave4done = 0;
-        while(slave4done == 0){
-            TX_Data[0] = 0x17;                        // address of I2C_MST_STATUS register
-            TX_ByteCtr = 1;
-            i2cWrite(slaveAddress);
-
-            RX_ByteCtr = 2;
-            i2cRead(slaveAddress);
-            register_value = RX_Data[1];
-
-            if(register_value & (1<<6)){
-                slave4done = 2;
-            }
-            else{
-               count++;
-               if(count == 1000){
-                   slave4done = 1;
-                   count = 0;
-               }
-            }
-        }
-
-        //configure Mag as slave0
-        TX_Data[1] = 0x7F;                      // address of BANK SEL register
-        TX_Data[0] = 0b00110000;                // Select BANK 3
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x03;                      // address of I2C_SLV0_ADDR register
-        TX_Data[0] = 0b10001100;                // BIT[6:0] to I2C slave address 0x0C; BIT[7] for RNW(read mode)
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x04;                      // address of I2C_SLV0_REG register
-        TX_Data[0] = 0b00010000;                // BIT[7:0] to register address 0x10 -->AK09916_REG_ST1
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-        TX_Data[1] = 0x05;                      // address of I2C_SLV0_CTRL register
-        TX_Data[0] = 0b10001001;                // BITS[3:0] for number of transmitted bytes(9),BIT[7] enable reading
-        TX_ByteCtr = 2;
-        i2cWrite(slaveAddress);
-
-
-
-
-
-      TX_Data[1] = 0x7F;                      // address of BANK SEL register
-      TX_Data[0] = 0b00000000;                // Select BANK 0
-      TX_ByteCtr = 2;
-      i2cWrite(slaveAddress);
+//--------------------------------------Initialize ICM20948--------------------------------------------------------------------------------------------
 
+      // wake up, reset and configure the ICM20948
+      icm_apply(icmInitTable, icmInitTableLen);
 
       mode = 1;                                 //start with standby mode after init
       measurementInit = 0;
+      P1OUT |= BIT0;                            // LED2 on = standby
 
 //--------------------------------------measurement loop-----------------------------------------------------------------------------------------
 
-      while(1){
-
-          if(mode == 1){
-          //standby mode
-              //wait in low power mode 0
-              P1OUT |= BIT0;                // LED2 on
-              __bis_SR_register(LPM0_bits);
-          }
-
-
-          else if(mode == 2){
-          //measurement mode including creating file, opening file, writing data to file and closing file
-              if(measurementInit == 0){
-              //measurement init phase = check DIP switch position, get current time, creating file, opening file
-
-                  //check switch setting for accel+gyro modes
-                  checkDIPswitch();
-
-                  TX_Data[1] = 0x7F;                      // address of BANK SEL register
-                  TX_Data[0] = 0b00100000;                // Select BANK 2
-                  TX_ByteCtr = 2;
-                  i2cWrite(slaveAddress);
-
-                  TX_Data[1] = 0x14;                      // address of ACCEL_CONFIG_1 register
-                  TX_Data[0] = G_MODE;                    // switch to selected accel mode
-                  TX_ByteCtr = 2;
-                  i2cWrite(slaveAddress);
-
-                  TX_Data[1] = 0x7F;                      // address of BANK SEL register
-                  TX_Data[0] = 0b00100000;                // Select BANK 2
-                  TX_ByteCtr = 2;
-                  i2cWrite(slaveAddress);
-
-                  TX_Data[1] = 0x01;                      // address of GYRO_CONFIG_1 register
-                  TX_Data[0] = DPS_MODE;                  // switch to selected gyro mode
-                  TX_ByteCtr = 2;
-                  i2cWrite(slaveAddress);
-
-                  TX_Data[1] = 0x7F;                      // address of BANK SEL register
-                  TX_Data[0] = 0b00000000;                // Select BANK 0
-                  TX_ByteCtr = 2;
-                  i2cWrite(slaveAddress);
-
-                  DS3234GetCurrentTime();
-
-                  char filename[] = "RAW_00.CSV";
-                  FILINFO fno;
-                  FRESULT fr;
-                  uint8_t i;
-                  for(i = 0; i < 100; i++){
-                      filename[4] = i / 10 + '0';
-                      filename[5] = i % 10 + '0';
-                      fr = f_stat(filename, &fno);
-                          if(fr == FR_OK){
-                              continue;
-                          }
-                          else if(fr == FR_NO_FILE){
-                                  break;
-                          }
-                          else{
-                              // Error occurred
-                              P4OUT |= BIT6;
-                              P1OUT |= BIT0;
-                              while(1);
-                          }
-                  }
-
-                  if(f_open(&logfile, filename, FA_WRITE | FA_OPEN_ALWAYS) == FR_OK) {    // Open file - If nonexistent, create
-                      f_lseek(&logfile, logfile.fsize);           // Move forward by filesize; logfile.fsize+1 is not needed in this application
-                  }
-                  f_printf(&logfile, "%s,%d,%s,%d,%s,%d,%s,%d,%s,%d,%s,%d,%s,%d\n","weekday: ",TimeArray[3],"//date: ",TimeArray[4],".",TimeArray[5],".",TimeArray[6],"//time: ",TimeArray[2],":",TimeArray[1],":",TimeArray[0]);
-                  f_printf(&logfile, "%d,%s,%d,%s\n",AccelSensitivity,"g",GyroSensitivity,"dps");
-                  f_printf(&logfile, "%s,%s,%s,%s,%s,%s,%s,%s,%s\n", "xAccel","yAccel","zAccel","xGyro","yGyro","zGyro","xMag","yMag","zMag");
-
-                  //P1OUT |= BIT0;                  //LED2 on
-                  measurementInit++;
-              }
-              else{
-              //writing data to file
-
-                  // Point to the ACCEL_XOUT_H register in the ICM20948
-                  TX_Data[0] = 0x2D;                        // register address
-                  TX_ByteCtr = 1;
-                  i2cWrite(slaveAddress);
-
-                  RX_ByteCtr = 23;
-                  i2cRead(slaveAddress);
-
-                  __disable_interrupt();                    // prevent getting new sensor data while saving values
-
-                  xAccel  = RX_Data[22] << 8;               // MSB
-                  xAccel |= RX_Data[21];                    // LSB
-                  yAccel  = RX_Data[20] << 8;
-                  yAccel |= RX_Data[19];
-                  zAccel  = RX_Data[18] << 8;
-                  zAccel |= RX_Data[17];
-                  xGyro  = RX_Data[16] << 8;
-                  xGyro |= RX_Data[15];
-                  yGyro  = RX_Data[14] << 8;
-                  yGyro |= RX_Data[13];
-                  zGyro  = RX_Data[12] << 8;
-                  zGyro |= RX_Data[11];
-                  Temp  = RX_Data[10] << 8;
-                  Temp |= RX_Data[9];
-                  magstat1 = RX_Data[8];
-                  magstat2 = RX_Data[0];
-                  if(!(magstat2 & (1<<3))){
-                  xMag = RX_Data[7];               // magnetometer puts data out in little endian
-                  xMag  |= RX_Data[6] << 8;
-                  yMag = RX_Data[5];
-                  yMag  |= RX_Data[4] << 8;
-                  zMag = RX_Data[3];
-                  zMag  |= RX_Data[2] << 8;
-                  }
-
-                  f_printf(&logfile, "%d,%d,%d,%d,%d,%d,%d,%d,%d\n", xAccel,yAccel,zAccel,xGyro,yGyro,zGyro,xMag,yMag,zMag);
-
-                  //backup every 3000 data writes --> every ~10s
-                  backupCtr++;
-                  if(backupCtr%250 == 0){
-                      P1OUT ^= BIT0;
-                  }
-                  if(backupCtr == 5000){
-                      f_sync(&logfile);
-                      backupCtr = 0;
-                  }
-
-                  __enable_interrupt();
-
-              }
-          }
-
-          else{
-              mode = 1;                                        //something went wrong --> switch to standby mode
-          }
-
-
-
-      }
-}
-
-/**********************************************************************************************/
-// Sensor I2C ISR
-#pragma vector = USCI_B0_VECTOR
-__interrupt void USCI_B0_ISR(void)
-{
-    if(UCB0CTL1 & UCTR)                 // TX mode (UCTR == 1)
-    {
-        if (TX_ByteCtr)                     // TRUE if more bytes remain
-        {
-            TX_ByteCtr--;               // Decrement TX byte counter
-            UCB0TXBUF = TX_Data[TX_ByteCtr];    // Load TX buffer
-        }
-        else                        // no more bytes to send
-        {
-            UCB0CTL1 |= UCTXSTP;            // I2C stop condition
-            UCB0IFG &= ~UCTXIFG;         // Clear USCI_B0 TX int flag
-            __bic_SR_register_on_exit(CPUOFF);  // Exit LPM0
-        }
-    }
-    else // (UCTR == 0)                 // RX mode
-    {
-        RX_ByteCtr--;                       // Decrement RX byte counter
-        if (RX_ByteCtr)                     // RxByteCtr != 0
-        {
-            RX_Data[RX_ByteCtr] = UCB0RXBUF;    // Get received byte
-            if (RX_ByteCtr == 1)            // Only one byte left?
-            UCB0CTL1 |= UCTXSTP;            // Generate I2C stop condition
-        }
-        else                        // RxByteCtr == 0
-        {
-            RX_Data[RX_ByteCtr] = UCB0RXBUF;    // Get final received byte
-            __bic_SR_register_on_exit(CPUOFF);  // Exit LPM0
-        }
-    }
+      sched_init(tasks);
+      sdBenchmark();                            //card is initialized by now, needs the Timer0_B time base
+      memBenchmark();
+      cardinfo_check(&sdVolume, &logfile);      //first mount of a card: time its writes, pick the block size
+      f_flush("");
+      ak_start();                               //magnetometer comes up in the background
+      sched_run();
 }
 
 /******************************************************************************/
@@ -1386,27 +1334,30 @@ void __attribute__ ((interrupt(USCI_A1_VECTOR))) USCI_A1_ISR (void)
 
 #pragma vector = PORT4_VECTOR
 __interrupt void ISR_Port4_S1(void){
+    //only start the debouncer, the press is validated in TIMER0_A0_ISR
+    P4IE &= ~BIT5;                  //ignore bounces until the button is released
+    P4IFG &= ~BIT5;                 // clear flag
+    buttonHeld = false;
+    TA0CTL = TASSEL__ACLK | MC__UP | TACLR;
+}
+/**********************************************************************************************/
 
-    if(mode == 1){                  //button press in standby mode
-        P1OUT &= ~BIT0;             //LED2 off
-        mode = 2;                   //switch to measurement mode
-        P4IFG &= ~BIT5;             // clear flag
-        __bic_SR_register_on_exit(LPM0_bits); //exit LPM0
-    }
-    else if(mode == 2){             //button press in measurement mode
-        P1OUT &= ~BIT0;             //LED2 off
-        mode = 1;                   //switch to standby mode
-        f_close(&logfile);          // Close the file
-        measurementInit = 0;        //reset value to open new file for the next measurement
-        P4IFG &= ~BIT5;             // clear flag
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void){
+    bool pressed = !(P4IN & BIT5);  //S1 is active low
+
+    if(!buttonHeld){                //first expiry after the edge
+        if(pressed){
+            buttonHeld = true;
+            sched_post(EVT_BUTTON);
+            __bic_SR_register_on_exit(LPM3_bits); //exit LPM3
+            return;                 //keep polling until released
+        }
     }
-    else{                           //something went wrong --> switch to standby mode
-        mode = 1;
-        P4IFG &= ~BIT5;             // clear flag
+    else if(pressed){
+        return;                     //still held
     }
-    _delay_cycles(800000);
-    _delay_cycles(800000);
-    _delay_cycles(800000);
-    _delay_cycles(800000);
-
+    TA0CTL = MC__STOP;              //released or bounce: arm the edge interrupt again
+    P4IFG &= ~BIT5;
+    P4IE |= BIT5;
 }
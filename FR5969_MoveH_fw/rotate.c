@@ -0,0 +1,201 @@
+/*
+ * rotate.c
+ *
+ *  Session file rotation, see rotate.h.
+ *
+ *  The FIL of the prepared part stays here until journal_rotate() moves it
+ *  into the session FIL; while no part is prepared it writes the manifest.
+ *  The manifest line of a finished part goes out from the next tick, so the
+ *  switch itself does not touch the directory.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rotate.h"
+#include "journal.h"
+#include "logbuf.h"
+#include "battery.h"
+
+#pragma PERSISTENT(rotateMinutes)
+uint16_t rotateMinutes = 0;
+#pragma PERSISTENT(rotateMb)
+uint16_t rotateMb = 0;
+
+#pragma DATA_SECTION(next, ".fram_buffers")
+static FIL next;                    // part prepared ahead, or the manifest
+
+static char name[13];               // last name from makeName()
+static char manName[] = "MAN_00.CSV";   // manifest of the session
+static char session[2];             // number of the session, "xx" of RAW_xx.CSV
+static uint8_t part = 0;            // running part, 0 = RAW_xx.CSV
+static bool ready = false;          // next part is open and extended
+static bool pending = false;        // manifest line of the part before is not written yet
+static bool late = false;           // a prepare from the disk task failed since the last tick
+static uint32_t maxBytes = ROTATE_BYTES_MAX;
+static uint32_t sessionStart = 0;   // clock_ms() at rotate_start
+static uint32_t partStart = 0;      // clock_ms() when the running part began
+static uint32_t lastStart = 0;      // the part before, for its manifest line
+static uint32_t lastBytes = 0;
+
+//*********************************************************************************************
+void rotate_set_minutes(const char *value){
+    rotateMinutes = (uint16_t)atoi(value);
+}
+//*********************************************************************************************
+void rotate_set_mb(const char *value){
+    rotateMb = (uint16_t)atoi(value);
+}
+//*********************************************************************************************
+// RAW_xx.CSV for part 0, RAWxx_nn.CSV after it
+static void makeName(uint8_t n){
+    if(n == 0){
+        strcpy(name, "RAW_00.CSV");
+        name[4] = session[0];
+        name[5] = session[1];
+    }
+    else{
+        strcpy(name, "RAW00_00.CSV");
+        name[3] = session[0];
+        name[4] = session[1];
+        name[6] = n / 10 + '0';
+        name[7] = n % 10 + '0';
+    }
+}
+//*********************************************************************************************
+static uint32_t limitMs(void){
+    return (uint32_t)rotateMinutes * 60000UL;
+}
+//*********************************************************************************************
+// append one part to the manifest, next must not be open
+static FRESULT writeLine(uint8_t n, uint32_t start, uint32_t end, uint32_t bytes){
+    FRESULT fr = f_open(&next, manName, FA_WRITE | FA_OPEN_ALWAYS);
+    FRESULT fc;
+
+    if(fr != FR_OK){
+        return fr;
+    }
+    fr = f_lseek(&next, next.fsize);
+    if(fr == FR_OK){
+        if(next.fsize == 0){
+            f_printf(&next, "%s,%s,%s,%s,%s\n", "part", "name", "t_start_ms", "t_end_ms", "bytes");
+        }
+        makeName(n);
+        f_printf(&next, "%u,%s,%lu,%lu,%lu\n", (unsigned int)n, name, start - sessionStart, end - sessionStart, bytes);
+    }
+    fc = f_close(&next);
+    return (fr == FR_OK) ? fc : fr;
+}
+//*********************************************************************************************
+void rotate_start(const char *first){
+    session[0] = first[4];
+    session[1] = first[5];
+    manName[4] = session[0];
+    manName[5] = session[1];
+    part = 0;
+    ready = false;
+    pending = false;
+    maxBytes = ROTATE_BYTES_MAX;
+    if(rotateMb && rotateMb < (ROTATE_BYTES_MAX >> 20)){
+        maxBytes = (uint32_t)rotateMb << 20;
+    }
+    sessionStart = clock_ms();
+    partStart = sessionStart;
+}
+//*********************************************************************************************
+// A lost manifest line does not stop the session, it is not tried again.
+static void writePending(void){
+    if(pending){
+        writeLine(part - 1, lastStart, partStart, lastBytes);
+        pending = false;
+    }
+}
+//*********************************************************************************************
+static FRESULT prepare(void){
+    FRESULT fr;
+
+    writePending();                     // next is needed for the part now
+    makeName(part + 1);
+    fr = journal_prepare(&next, name);
+    ready = (fr == FR_OK);
+    return fr;
+}
+//*********************************************************************************************
+// The next part is prepared once the running one is within an extent of its
+// size limit or ROTATE_LEAD_MS of its time limit.
+void rotate_tick(const FIL *fp){
+    late = false;
+    if(!ready){
+        writePending();
+    }
+    if(ready || part >= ROTATE_PARTS_MAX){
+        return;
+    }
+    if(fp->fptr + JOURNAL_RESERVE < maxBytes &&
+       (!rotateMinutes || clock_ms() - partStart + ROTATE_LEAD_MS < limitMs())){
+        return;
+    }
+    prepare();
+}
+//*********************************************************************************************
+// Due even if the tick has not prepared the next part yet, rotate_switch()
+// then does it itself, once per tick if that fails.
+bool rotate_due(const FIL *fp){
+    return part < ROTATE_PARTS_MAX && (ready || !late) &&
+           (fp->fptr >= maxBytes || (rotateMinutes && clock_ms() - partStart >= limitMs()));
+}
+//*********************************************************************************************
+// The sector block holds whole lines only, all of them go to the old part.
+// On an error fp is left as sd_recover() can handle it: still open in the
+// old part, or closed with the journal record naming the old part. Without
+// a disk error the session simply goes on in the old part.
+FRESULT rotate_switch(FIL *fp){
+    uint32_t bytes;
+    FRESULT fr = FR_OK;
+
+    if(!ready){
+        fr = prepare();                 // late tick: the disk task pays for the prepare
+        late = (fr != FR_OK);
+    }
+    if(fr == FR_OK){
+        fr = logbuf_flush(fp);
+    }
+    if(fr != FR_OK){
+        return fr;
+    }
+    bytes = fp->fptr;
+    fr = journal_rotate(fp, &next);
+    if(fr != FR_OK){
+        return fr;
+    }
+    logbuf_resume(fp);                  // the block is empty, it starts over in the new part
+    ready = false;
+    lastStart = partStart;
+    lastBytes = bytes;
+    partStart = clock_ms();
+    part++;
+    pending = true;
+    return FR_OK;
+}
+//*********************************************************************************************
+// the file stays on the card and in the journal record, the next prepare
+// creates it again
+void rotate_lost(void){
+    ready = false;
+}
+//*********************************************************************************************
+void rotate_stop(FIL *fp){
+    if(ready){
+        f_close(&next);
+        ready = false;
+    }
+    journal_discard();                  // also a part left behind by rotate_lost()
+    if(pending){
+        writeLine(part - 1, lastStart, partStart, lastBytes);
+        pending = false;
+    }
+    if(part || rotateMinutes || rotateMb){
+        writeLine(part, partStart, clock_ms(), fp->fptr);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * rotate.h
+ *
+ *  Session file rotation. The raw data of a session is split into parts,
+ *  RAW_xx.CSV first, then RAWxx_01.CSV, RAWxx_02.CSV, ..., each one ending
+ *  after rotateMinutes or rotateMb, and always below 4 GB. The 1 Hz tick
+ *  creates the next part with its first extent ahead of the switch
+ *  (journal_prepare), so the switch between two lines only flushes the
+ *  sector block and closes the old part. With rotation set, or once a part
+ *  was switched, MAN_xx.CSV lists the parts of the session, one line each:
+ *
+ *      part,name,t_start_ms,t_end_ms,bytes
+ */
+
+#ifndef ROTATE_H_
+#define ROTATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "./FatFS/ff.h"
+
+#define ROTATE_PARTS_MAX    99          // RAWxx_99.CSV is the last part
+#define ROTATE_LEAD_MS      30000UL     // next part is prepared this long before the time limit
+#define ROTATE_BYTES_MAX    0xF0000000UL    // FAT32 limit minus room for an extent carried to the AU end
+
+extern uint16_t rotateMinutes;      // FRAM, 0 = no time limit
+extern uint16_t rotateMb;           // FRAM, 0 = ROTATE_BYTES_MAX only
+
+void rotate_set_minutes(const char *value);     // "rotate_min=" from CONFIG.TXT
+void rotate_set_mb(const char *value);          // "rotate_mb=" from CONFIG.TXT
+
+void rotate_start(const char *name);            // session start, name of the first part
+void rotate_tick(const FIL *fp);                // 1 Hz during a session: manifest line, next part
+bool rotate_due(const FIL *fp);                 // part is full
+FRESULT rotate_switch(FIL *fp);                 // between two lines, fp goes on in the next part
+void rotate_lost(void);                         // the prepared part went stale with a remount
+void rotate_stop(FIL *fp);                      // after logbuf_flush, before journal_close
+
+#endif /* ROTATE_H_ */
@@ -0,0 +1,101 @@
+/*
+ * sched.c
+ *
+ *  Cooperative event scheduler, see sched.h.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include "sched.h"
+
+sched_stat_t schedStats[SCHED_EVENTS];
+
+static const sched_handler_t *taskTable;
+static volatile uint16_t pending = 0;          // one bit per event
+static uint16_t pass = 0;                      // events of the running pass not served yet
+static volatile uint16_t timeHigh = 0;         // Timer0_B overflow count
+
+//*********************************************************************************************
+void sched_init(const sched_handler_t *handlers){
+    taskTable = handlers;
+    sched_clear();
+
+    // Timer0_B: free running time base for task accounting. It runs from SMCLK,
+    // so it stops together with the CPU in LPM3 and costs nothing while idle.
+    TB0CTL = TBSSEL__SMCLK | ID__8 | MC__CONTINUOUS | TBCLR | TBIE;
+}
+//*********************************************************************************************
+void sched_clear(void){
+    uint8_t i;
+
+    for(i = 0; i < SCHED_EVENTS; i++){
+        schedStats[i].runs = 0;
+        schedStats[i].ticks = 0;
+        schedStats[i].worst = 0;
+    }
+}
+//*********************************************************************************************
+void sched_post(uint8_t evt){
+    uint16_t gie = __get_SR_register() & GIE;
+    __disable_interrupt();
+    pending |= (1 << evt);
+    __bis_SR_register(gie);
+}
+//*********************************************************************************************
+uint32_t sched_now(void){
+    uint16_t hi, lo;
+    uint16_t gie = __get_SR_register() & GIE;
+
+    __disable_interrupt();
+    hi = timeHigh;
+    lo = TB0R;
+    if(TB0CTL & TBIFG){                         // overflow not yet serviced
+        hi++;
+        lo = TB0R;
+    }
+    __bis_SR_register(gie);
+    return ((uint32_t)hi << 16) | lo;
+}
+//*********************************************************************************************
+void sched_run(void){
+    uint8_t evt;
+    uint32_t start, took;
+
+    while(1){
+        __disable_interrupt();
+        if(!pass){
+            if(!pending){
+                __bis_SR_register(LPM3_bits | GIE);  // no event can slip in between check and sleep
+                continue;
+            }
+            pass = pending;                     // events posted from here on wait for the next pass
+            pending = 0;
+        }
+        __enable_interrupt();
+        for(evt = 0; !(pass & (1 << evt)); evt++);
+        pass &= ~(1 << evt);
+
+        if(taskTable[evt]){
+            start = sched_now();
+            taskTable[evt]();
+            took = sched_now() - start;
+            schedStats[evt].runs++;
+            schedStats[evt].ticks += took;
+            if(took > schedStats[evt].worst){
+                schedStats[evt].worst = took;
+            }
+        }
+    }
+}
+//*********************************************************************************************
+
+#pragma vector = TIMER0_B1_VECTOR
+__interrupt void TIMER0_B1_ISR(void){
+    switch(__even_in_range(TB0IV, TBIV__TBIFG)){
+        case TBIV__TBIFG:
+            timeHigh++;
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * sched.h
+ *
+ *  Run-to-completion scheduler for the main loop. Interrupts and tasks post
+ *  events; sched_run() takes the pending events as one pass and dispatches
+ *  their handlers in priority order (lowest event number first). An event
+ *  posted during a pass, even by its own handler, runs in the next pass, so
+ *  a task that keeps posting itself cannot starve the ones below it. The
+ *  loop sleeps in LPM3 when nothing is pending. Every dispatch is timed with
+ *  Timer0_B for per-task accounting.
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+
+// events in priority order, highest first
+enum sched_events {
+    EVT_LOW_BATTERY,        // supply dropped below BATTERY_LOW_MV
+    EVT_BUTTON,             // debounced press of S1
+    EVT_BUFFER_FULL,        // sample ring needs to be written to the card
+    EVT_SENSOR_READY,       // next sample can be read from the ICM20948
+    EVT_MAG_TICK,           // 1 ms tick during AK09916 bring-up
+    EVT_RTC_TICK,           // 1 Hz housekeeping
+    SCHED_EVENTS
+};
+
+typedef void (*sched_handler_t)(void);
+
+// per-task accounting, times in Timer0_B ticks (SMCLK / 8)
+typedef struct {
+    uint32_t runs;          // number of dispatches
+    uint64_t ticks;         // total run time, 32 bits last only 36 min of it
+    uint32_t worst;         // longest single run
+} sched_stat_t;
+
+extern sched_stat_t schedStats[SCHED_EVENTS];
+
+void sched_init(const sched_handler_t *handlers);  // SCHED_EVENTS entries, 0 = ignore
+void sched_clear(void);                            // restart the accounting, e.g. with a session
+void sched_post(uint8_t evt);                      // from tasks or ISRs, ISRs then exit LPM3_bits
+uint32_t sched_now(void);                          // Timer0_B ticks since sched_init
+void sched_run(void);                              // never returns
+
+#endif /* SCHED_H_ */
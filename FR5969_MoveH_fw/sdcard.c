@@ -0,0 +1,123 @@
+/*
+ * sdcard.c
+ *
+ *  SD card error handling, see sdcard.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "sdcard.h"
+#include "./FatFS/diskio.h"
+#include "journal.h"
+#include "logbuf.h"
+#include "battery.h"
+
+#pragma PERSISTENT(sdBusyMs)
+uint16_t sdBusyMs = 500;
+#pragma PERSISTENT(sdReadMs)
+uint16_t sdReadMs = 100;
+bool sdFailed = false;
+sd_stats_t sdStats = {0};
+
+static uint8_t retryTick = 0;
+static uint16_t cardBusyMs = 0;     // floor from the card profile
+
+static const char * const recoverNames[] = {"retry", "remount", "failed"};
+
+//*********************************************************************************************
+// ms to 10 ms ticks of the disk timer, at least one tick
+static uint16_t toTicks(uint16_t ms){
+    ms = (ms + 9) / 10;
+    return ms ? ms : 1;
+}
+//*********************************************************************************************
+// the configured timeout, but never below what the card was seen to need
+static void applyBusy(void){
+    DiskTiming.busy = toTicks(sdBusyMs > cardBusyMs ? sdBusyMs : cardBusyMs);
+}
+//*********************************************************************************************
+void sd_set_busy(const char *value){
+    sdBusyMs = (uint16_t)atoi(value);
+    applyBusy();
+}
+//*********************************************************************************************
+void sd_set_card_busy(uint16_t ms){
+    cardBusyMs = ms;
+    applyBusy();
+}
+//*********************************************************************************************
+void sd_set_read(const char *value){
+    sdReadMs = (uint16_t)atoi(value);
+    DiskTiming.read = toTicks(sdReadMs);
+}
+//*********************************************************************************************
+void sd_init(void){
+    applyBusy();
+    DiskTiming.read = toTicks(sdReadMs);
+}
+//*********************************************************************************************
+// unregister the volume and mount it again right away, disk_initialize runs now
+static FRESULT remount(FATFS *fs){
+    f_mount(0, "", 0);
+    return f_mount(fs, "", 1);
+}
+//*********************************************************************************************
+sd_recover_t sd_recover(FATFS *fs, FIL *fp){
+    sd_recover_t how = SD_RECOVER_FAILED;
+    uint32_t start = clock_ms();
+    uint8_t i;
+
+    sdStats.errors++;
+
+    // Log blocks bypass fp->buf, the block the card missed is still in the
+    // FRAM block of logbuf. f_sync writes what FatFs holds (FAT, directory
+    // entry), then the block goes out again; only both make a retry.
+    for(i = 0; i < SD_RETRIES; i++){
+        fp->err = 0;
+        if(f_sync(fp) == FR_OK){
+            if(logbuf_retry(fp) == FR_OK){
+                how = SD_RECOVER_RETRY;
+                sdStats.retries++;
+                break;
+            }
+            sdStats.blockFails++;
+        }
+    }
+
+    // card stuck or reset: initialize it again, the FIL is invalid after the remount
+    if(how == SD_RECOVER_FAILED && remount(fs) == FR_OK && journal_reopen(fp) == FR_OK){
+        logbuf_resume(fp);          // the FRAM block still holds what the card missed
+        how = SD_RECOVER_REMOUNT;
+        sdStats.remounts++;
+    }
+
+    if(how == SD_RECOVER_FAILED){
+        sdStats.failovers++;
+        sdFailed = true;
+        retryTick = 0;
+    }
+    sdStats.lastMs = clock_ms() - start;
+    if(sdStats.lastMs > sdStats.worstMs){
+        sdStats.worstMs = sdStats.lastMs;
+    }
+    return how;
+}
+//*********************************************************************************************
+const char *sd_recover_name(sd_recover_t how){
+    return recoverNames[how];
+}
+//*********************************************************************************************
+// the journal record of the abandoned session is still open, the file is
+// trimmed to the committed size as soon as the card can be mounted again
+bool sd_retry_tick(FATFS *fs, FIL *fp){
+    if(++retryTick < SD_RETRY_S){
+        return false;
+    }
+    retryTick = 0;
+    if(remount(fs) != FR_OK || journal_recover(fp) != FR_OK){
+        return false;
+    }
+    sdFailed = false;
+    return true;
+}
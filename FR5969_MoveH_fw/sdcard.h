@@ -0,0 +1,54 @@
+/*
+ * sdcard.h
+ *
+ *  Handling of SD card errors during a session. diskio.c bounds every wait
+ *  for the card with the 10 ms Timer1_A tick, so a stalled card ends in
+ *  FR_DISK_ERR instead of a hang. sd_recover() then works through three
+ *  levels: write the failed block again, re-initialize and remount the card
+ *  and reopen the session file at the last journal commit, or give up so the
+ *  session can be ended without the card. After giving up, sd_retry_tick()
+ *  tries to mount the card every SD_RETRY_S seconds.
+ */
+
+#ifndef SDCARD_H_
+#define SDCARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "./FatFS/ff.h"
+
+#define SD_RETRIES          2       // f_sync attempts before the card is remounted
+#define SD_RETRY_S          10      // seconds between mount attempts after a failover
+
+typedef enum {
+    SD_RECOVER_RETRY,               // log block written on a retry
+    SD_RECOVER_REMOUNT,             // card re-initialized, file reopened
+    SD_RECOVER_FAILED               // card unusable, session has to end
+} sd_recover_t;
+
+// errors and the time spent on them since boot
+typedef struct {
+    uint16_t errors;                // calls of sd_recover()
+    uint16_t retries;               // recovered by writing again
+    uint16_t blockFails;            // f_sync worked on a retry, the log block failed again
+    uint16_t remounts;              // recovered by remounting
+    uint16_t failovers;             // sessions ended because of the card
+    uint32_t lastMs;                // duration of the last recovery
+    uint32_t worstMs;               // longest recovery
+} sd_stats_t;
+
+extern uint16_t sdBusyMs;           // FRAM, card busy timeout
+extern uint16_t sdReadMs;           // FRAM, read data timeout
+extern bool sdFailed;               // card given up, no session can be started
+extern sd_stats_t sdStats;
+
+void sd_set_busy(const char *value);    // "sd_busy_ms=" from CONFIG.TXT
+void sd_set_read(const char *value);    // "sd_read_ms=" from CONFIG.TXT
+void sd_set_card_busy(uint16_t ms);     // lower limit of the busy timeout, from the card profile
+
+void sd_init(void);                         // at boot before f_mount, applies the FRAM timeouts
+sd_recover_t sd_recover(FATFS *fs, FIL *fp);    // after a failed write to the session file fp
+const char *sd_recover_name(sd_recover_t how);
+bool sd_retry_tick(FATFS *fs, FIL *fp);     // 1 Hz while sdFailed, true once the card is back
+
+#endif /* SDCARD_H_ */
@@ -0,0 +1,235 @@
+/*
+ * ahrs_check.c
+ *
+ *  Host check of the fixed-point Mahony filter in ahrs.c against the same
+ *  filter in double precision:
+ *
+ *      gcc -O2 -Wall -I. -o ahrs_check tools/ahrs_check.c ahrs.c -lm
+ *      ./ahrs_check
+ *
+ *  run in FR5969_MoveH_fw. Each test vector is a motion of a simulated
+ *  logger: the true orientation is integrated from a body rate, accel, gyro
+ *  and magnetometer readings are derived from it, quantized to the raw
+ *  sensor LSB with some noise, and fed to both filters. After SETTLE_S the
+ *  angle between the fixed-point and the float quaternion must stay below
+ *  MAX_DEG; the angle of the float filter to the true orientation is shown
+ *  for scale. Exits with 1 if a vector fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "../ahrs.h"
+
+#define PI              3.14159265358979
+#define SETTLE_S        5.0     // both filters start at identity, a tilted start takes a few s
+#define MAX_DEG         0.5     // fixed against float after SETTLE_S
+#define RUN_S           60.0
+#define FIELD_X         20.0    // earth field in uT, north and down, 65 degrees inclination
+#define FIELD_Z         43.0
+#define MAG_UT_LSB      0.15    // AK09916
+
+typedef struct {
+    const char *name;
+    uint16_t periodMs;          // sample period
+    uint8_t rangeG;
+    uint16_t rangeDps;
+    double roll, pitch;         // true start orientation, degrees
+    double rate[3];             // constant part of the body rate, dps
+    double wobble[3];           // amplitude of a sine on top of it, dps
+    double bias[3];             // gyro bias, dps, the filter has no integral term
+} vector_t;
+
+static const vector_t vectors[] = {
+    {"level, still",        10,  2,  250,   0,   0, {  0,   0,   0}, {  0,   0,   0}, {0,    0,   0}},
+    {"tilted start",        10,  2,  250,  30, -20, {  0,   0,   0}, {  0,   0,   0}, {0,    0,   0}},
+    {"yaw 90 dps",          10,  2,  250,   0,   0, {  0,   0,  90}, {  0,   0,   0}, {0,    0,   0}},
+    {"tumbling",            10,  4,  500,  10,   5, {  0,   0,  20}, { 60,  45, 120}, {0,    0,   0}},
+    {"tumbling, 50 Hz",     20,  4,  500,  10,   5, {  0,   0,  20}, { 60,  45, 120}, {0,    0,   0}},
+    {"fast spin",           10,  8, 2000,   0,  45, {700,   0, 300}, {  0,   0,   0}, {0,    0,   0}},
+    {"gyro bias",           10,  2,  250,  15,  15, {  0,   0,   0}, { 20,  20,  20}, {0.5, -0.3, 0.4}},
+};
+
+static double ref[4];                  // float filter, w x y z
+static uint32_t noise = 12345;
+
+uint32_t sched_now(void){
+    return 0;
+}
+//*********************************************************************************************
+// deterministic noise in [-1, 1]
+static double rnd(void){
+    noise = noise * 1103515245UL + 12345;
+    return ((noise >> 8) & 0xFFFF) / 32767.5 - 1.0;
+}
+//*********************************************************************************************
+static int16_t quantize(double v){
+    v = floor(v + 0.5);
+    if(v > 32767) v = 32767;
+    if(v < -32768) v = -32768;
+    return (int16_t)v;
+}
+//*********************************************************************************************
+static void normalize(double *v, int n){
+    double s = 0;
+    int i;
+
+    for(i = 0; i < n; i++) s += v[i] * v[i];
+    s = sqrt(s);
+    for(i = 0; i < n; i++) v[i] /= s;
+}
+//*********************************************************************************************
+// body vector of the earth vector e for the orientation q (body to earth)
+static void toBody(const double *q, const double *e, double *b){
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+
+    b[0] = (1 - 2 * (y * y + z * z)) * e[0] + 2 * (x * y + w * z) * e[1] + 2 * (x * z - w * y) * e[2];
+    b[1] = 2 * (x * y - w * z) * e[0] + (1 - 2 * (x * x + z * z)) * e[1] + 2 * (y * z + w * x) * e[2];
+    b[2] = 2 * (x * z + w * y) * e[0] + 2 * (y * z - w * x) * e[1] + (1 - 2 * (x * x + y * y)) * e[2];
+}
+//*********************************************************************************************
+// q += q * (0, h), h = half angle of the step
+static void rotate(double *q, const double *h){
+    double p0 = q[0], p1 = q[1], p2 = q[2], p3 = q[3];
+
+    q[0] = p0 - p1 * h[0] - p2 * h[1] - p3 * h[2];
+    q[1] = p1 + p0 * h[0] + p2 * h[2] - p3 * h[1];
+    q[2] = p2 + p0 * h[1] - p1 * h[2] + p3 * h[0];
+    q[3] = p3 + p0 * h[2] + p1 * h[1] - p2 * h[0];
+    normalize(q, 4);
+}
+//*********************************************************************************************
+// ahrs_update() in double precision, the same terms without rounding
+static void refUpdate(const sample_t *smp, double radPerLsb, double dt){
+    double q0 = ref[0], q1 = ref[1], q2 = ref[2], q3 = ref[3];
+    double a[3], m[3], e[3] = {0, 0, 0}, g[3], h[3];
+    double vx, vy, vz, hx, hy, hz, bx, bz, wx, wy, wz;
+    int i;
+
+    vx = 2 * (q1 * q3 - q0 * q2);
+    vy = 2 * (q0 * q1 + q2 * q3);
+    vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+    a[0] = smp->xAccel;
+    a[1] = smp->yAccel;
+    a[2] = smp->zAccel;
+    normalize(a, 3);
+    e[0] = a[1] * vz - a[2] * vy;
+    e[1] = a[2] * vx - a[0] * vz;
+    e[2] = a[0] * vy - a[1] * vx;
+
+    m[0] = smp->xMag;
+    m[1] = -smp->yMag;
+    m[2] = -smp->zMag;
+    normalize(m, 3);
+    hx = 2 * (m[0] * (0.5 - q2 * q2 - q3 * q3) + m[1] * (q1 * q2 - q0 * q3) + m[2] * (q1 * q3 + q0 * q2));
+    hy = 2 * (m[0] * (q1 * q2 + q0 * q3) + m[1] * (0.5 - q1 * q1 - q3 * q3) + m[2] * (q2 * q3 - q0 * q1));
+    hz = 2 * (m[0] * (q1 * q3 - q0 * q2) + m[1] * (q2 * q3 + q0 * q1) + m[2] * (0.5 - q1 * q1 - q2 * q2));
+    bx = sqrt(hx * hx + hy * hy);
+    bz = hz;
+    wx = 2 * (bx * (0.5 - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2));
+    wy = 2 * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3));
+    wz = 2 * (bx * (q0 * q2 + q1 * q3) + bz * (0.5 - q1 * q1 - q2 * q2));
+    e[0] += m[1] * wz - m[2] * wy;
+    e[1] += m[2] * wx - m[0] * wz;
+    e[2] += m[0] * wy - m[1] * wx;
+
+    g[0] = smp->xGyro * radPerLsb;
+    g[1] = smp->yGyro * radPerLsb;
+    g[2] = smp->zGyro * radPerLsb;
+    for(i = 0; i < 3; i++){
+        g[i] += AHRS_KP_Q8 / 256.0 * e[i];
+        h[i] = g[i] * dt / 2;
+    }
+    rotate(ref, h);
+}
+//*********************************************************************************************
+// angle between two orientations in degrees
+static double angle(const double *a, const double *b){
+    double d = fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+
+    return d >= 1 ? 0 : 2 * acos(d) * 180 / PI;
+}
+//*********************************************************************************************
+static int run(const vector_t *v){
+    const double gravity[3] = {0, 0, 1};
+    const double field[3] = {FIELD_X, 0, FIELD_Z};
+    double truth[4], fix[4], w[3], h[3], b[3];
+    double dt = v->periodMs / 1000.0, t;
+    double lsbPerG = 32768.0 / v->rangeG, lsbPerDps = 32768.0 / v->rangeDps;
+    double worst = 0, sum = 0, drift = 0, norm = 0, d;
+    long n = 0;
+    sample_t smp = {0};
+    int i, k;
+
+    // start orientation from roll and pitch
+    truth[0] = cos(v->roll * PI / 360) * cos(v->pitch * PI / 360);
+    truth[1] = sin(v->roll * PI / 360) * cos(v->pitch * PI / 360);
+    truth[2] = cos(v->roll * PI / 360) * sin(v->pitch * PI / 360);
+    truth[3] = -sin(v->roll * PI / 360) * sin(v->pitch * PI / 360);
+    ref[0] = 1;
+    ref[1] = ref[2] = ref[3] = 0;
+    ahrs_start(v->rangeDps);
+
+    for(t = 0; t < RUN_S; t += dt){
+        for(i = 0; i < 3; i++){
+            w[i] = v->rate[i] + v->wobble[i] * sin((0.3 + 0.2 * i) * 2 * PI * t);
+        }
+        // true motion over the sample period in ten sub-steps
+        for(k = 0; k < 10; k++){
+            for(i = 0; i < 3; i++){
+                h[i] = w[i] * PI / 180 * dt / 20;
+            }
+            rotate(truth, h);
+        }
+
+        smp.time = (uint32_t)(t * 1000 + 0.5);
+        toBody(truth, gravity, b);
+        smp.xAccel = quantize(b[0] * lsbPerG + rnd() * 0.004 * lsbPerG);
+        smp.yAccel = quantize(b[1] * lsbPerG + rnd() * 0.004 * lsbPerG);
+        smp.zAccel = quantize(b[2] * lsbPerG + rnd() * 0.004 * lsbPerG);
+        smp.xGyro = quantize((w[0] + v->bias[0] + rnd() * 0.05) * lsbPerDps);
+        smp.yGyro = quantize((w[1] + v->bias[1] + rnd() * 0.05) * lsbPerDps);
+        smp.zGyro = quantize((w[2] + v->bias[2] + rnd() * 0.05) * lsbPerDps);
+        toBody(truth, field, b);
+        smp.xMag = quantize(b[0] / MAG_UT_LSB + rnd() * 2);
+        smp.yMag = quantize(-b[1] / MAG_UT_LSB + rnd() * 2);
+        smp.zMag = quantize(-b[2] / MAG_UT_LSB + rnd() * 2);
+
+        ahrs_update(&smp);
+        refUpdate(&smp, PI / 180 / lsbPerDps, n ? dt : 0);
+        n++;
+
+        if(t < SETTLE_S){
+            continue;
+        }
+        for(i = 0; i < 4; i++){
+            fix[i] = smp.q[i] / (double)AHRS_ONE;
+        }
+        d = fabs(sqrt(fix[0] * fix[0] + fix[1] * fix[1] + fix[2] * fix[2] + fix[3] * fix[3]) - 1);
+        if(d > norm) norm = d;
+        normalize(fix, 4);                  // a norm error of 1e-4 alone would read as 1.6 degrees
+        d = angle(fix, ref);
+        sum += d * d;
+        if(d > worst) worst = d;
+        d = angle(ref, truth);
+        if(d > drift) drift = d;
+    }
+    n = (long)((RUN_S - SETTLE_S) / dt);
+    printf("%-18s %8.3f %8.3f %10.3f %10.5f  %s\n", v->name, worst, sqrt(sum / n), drift, norm,
+           worst < MAX_DEG ? "ok" : "FAIL");
+    return worst < MAX_DEG;
+}
+//*********************************************************************************************
+int main(void){
+    unsigned int i, failed = 0;
+
+    printf("%-18s %8s %8s %10s %10s\n", "vector", "max", "rms", "ref-true", "|q|-1");
+    for(i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++){
+        if(!run(&vectors[i])){
+            failed++;
+        }
+    }
+    printf("angles in degrees, fixed against float after %.0f s\n", SETTLE_S);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * au_check.c
+ *
+ *  Host check of the allocation unit placement in ff.c (create_chain_au(),
+ *  find_au(), f_preerase()) and of extendExtent() in journal.c, on a RAM
+ *  disk behind a model of the card's AU handling:
+ *
+ *      gcc -O2 -Wall -Wno-unknown-pragmas -I. -Itools -o au_check tools/au_check.c tools/ramdisk.c
+ *      ./au_check
+ *
+ *  run in FR5969_MoveH_fw. The same sessions run twice: RAW through logbuf
+ *  and the journal, ACT and EVT with a sync per line, and some of the files
+ *  removed halfway to leave gaps. Once with AU placement, once with
+ *  fs.au = 0 like a card that reports no AU. With AU placement
+ *    - every extent of a RAW file ends on an AU boundary,
+ *    - every AU a RAW file enters belongs to it from there to the boundary,
+ *    - the RAW data of every AU reaches the card in order.
+ *  In both runs all files must read back and the volume pass the fsck in
+ *  ramdisk.c, and the model has to charge the AU placement less than the
+ *  run without it. Exits with 1 if a check fails.
+ *
+ *  Card model: OPEN_AUS AUs are open at a time. A sector at the write
+ *  pointer of an open AU costs 1, any other sector of it SEEK_COST. Another
+ *  AU closes the one used least recently, which costs OPEN_COST plus the
+ *  sectors behind its write pointer that the card copies to close it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ramdisk.h"
+#include "../FatFS/ff.c"
+#include "../journal.c"
+#include "../logbuf.c"
+
+#define SECTORS         270000UL    // FAT32 needs 65525 clusters
+#define CLUSTER_SECTORS 4
+#define AU_SECTORS      2048UL      // 1 MB allocation units
+#define SESSIONS        10
+#define OPEN_AUS        2
+#define SEEK_COST       4
+#define OPEN_COST       100
+#define ACT_EVERY       30          // RAW lines per ACT line
+#define EVT_EVERY       700         // RAW lines per EVT line
+
+static FATFS fs;
+static FIL raw, act, evt;
+static unsigned long sessionLines[SESSIONS];
+static int failures = 0;
+
+// card model, see the header
+static long openAu[OPEN_AUS];
+static DWORD writePtr[OPEN_AUS], lastUse[OPEN_AUS], tick;
+static unsigned long cost, opens, seeks, sectors;
+
+// data area writes of the running session, for the order within each AU
+static DWORD *trace;
+static unsigned long traced;
+
+//*********************************************************************************************
+static void cardWrite(DWORD sector, UINT count){
+    long au;
+    UINT k;
+    int i, v;
+
+    for(k = 0; k < count; k++, sector++){
+        au = (long)(sector / AU_SECTORS);
+        for(i = 0; i < OPEN_AUS && openAu[i] != au; i++);
+        if(i == OPEN_AUS){
+            for(v = 0, i = 1; i < OPEN_AUS; i++){
+                if(lastUse[i] < lastUse[v]) v = i;
+            }
+            if(openAu[v] >= 0){
+                cost += (openAu[v] + 1) * AU_SECTORS - writePtr[v];
+            }
+            cost += OPEN_COST;
+            opens++;
+            openAu[v] = au;
+            writePtr[v] = sector;
+            i = v;
+        }
+        if(sector == writePtr[i]){
+            cost++;
+        }
+        else{
+            cost += SEEK_COST;
+            seeks++;
+        }
+        if(sector + 1 > writePtr[i]){
+            writePtr[i] = sector + 1;
+        }
+        lastUse[i] = ++tick;
+        if(writePtr[i] == (DWORD)(au + 1) * AU_SECTORS){
+            openAu[i] = -1;             // full, the card closes it for free
+            lastUse[i] = 0;
+        }
+        sectors++;
+        if(trace && sector >= fs.database){
+            trace[traced++] = sector;
+        }
+    }
+}
+//*********************************************************************************************
+// an empty card in a logger that never ran
+static void start(int align){
+    int i;
+
+    memset(&fs, 0, sizeof(fs));
+    Fsid = 0;
+    memset(PoolOwner, 0, sizeof(PoolOwner));
+    memset(PoolUse, 0, sizeof(PoolUse));
+    PoolClock = 0;
+    WinCacheFs = 0;
+    GeoCacheFs = 0;
+    memset(journalSlot, 0, sizeof(journalSlot));
+    memset(&rec, 0, sizeof(rec));
+    active = 0;
+    state.base = 0;
+    state.limit = _MAX_SS;
+    state.len = 0;
+    state.done = 0;
+    line = block;
+
+    ramdisk_init(SECTORS, AU_SECTORS);
+    ramdisk_format(CLUSTER_SECTORS, 0x4A430100 + align);
+    f_mount(&fs, "", 1);
+    if(!align){
+        fs.au = 0;
+    }
+    for(i = 0; i < OPEN_AUS; i++){
+        openAu[i] = -1;
+        lastUse[i] = 0;
+    }
+    tick = cost = opens = seeks = sectors = 0;
+    ramdiskWriteHook = cardWrite;
+}
+//*********************************************************************************************
+static void rawLine(char *s, unsigned long i){
+    sprintf(s, "%lu,%lu,%s\n", i, i * 7, "0123456789abcdef");
+}
+static void actLine(char *s, unsigned long i){
+    sprintf(s, "%lu,%lu\n", i * ACT_EVERY, i * 3);
+}
+static void evtLine(char *s, unsigned long i){
+    sprintf(s, "sd_error,%lu,retry,3\n", i * EVT_EVERY);
+}
+//*********************************************************************************************
+// lines in the file if each is the next of gen, -1 otherwise
+static long checkFile(const char *name, void (*gen)(char *, unsigned long)){
+    static char buf[4096];
+    char expect[64];
+    FIL f;
+    UINT br, i, n = 0;
+    long count = 0;
+
+    if(f_open(&f, name, FA_READ) != FR_OK){
+        return -1;
+    }
+    gen(expect, 0);
+    while(f_read(&f, buf, sizeof(buf), &br) == FR_OK && br){
+        for(i = 0; i < br; i++){
+            if(buf[i] != expect[n]){
+                f_close(&f);
+                return -1;
+            }
+            if(buf[i] == '\n'){
+                gen(expect, ++count);
+                n = 0;
+            }
+            else{
+                n++;
+            }
+        }
+    }
+    f_close(&f);
+    return n ? -1 : count;
+}
+//*********************************************************************************************
+// last cluster of the chain that starts at c
+static DWORD chainEnd(DWORD c){
+    DWORD n;
+
+    while((n = get_fat(&fs, c)) >= 2 && n < fs.n_fatent){
+        c = n;
+    }
+    return c;
+}
+//*********************************************************************************************
+static int auBoundaryAfter(DWORD c){
+    return (clust2sect(&fs, c) + CLUSTER_SECTORS) % AU_SECTORS == 0;
+}
+//*********************************************************************************************
+// startMeasurement(), the sample lines and stopMeasurement(), with the
+// extent checks after every extension
+static void session(int n, unsigned long lines, int align){
+    char name[16], s[64];
+    unsigned long i, bad = 0;
+    DWORD reserved;
+    UINT bw;
+
+    if(align){
+        f_preerase("", JOURNAL_RESERVE);
+    }
+    sprintf(name, "ACT_%02d.CSV", n);
+    f_open(&act, name, FA_WRITE | FA_CREATE_ALWAYS);
+    sprintf(name, "EVT_%02d.CSV", n);
+    f_open(&evt, name, FA_WRITE | FA_CREATE_ALWAYS);
+    sprintf(name, "RAW_%02d.CSV", n);
+    f_open(&raw, name, FA_WRITE | FA_CREATE_ALWAYS | FA_ALIGN);
+    journal_open(&raw, name);
+    logbuf_open(&raw);
+    reserved = rec.reserved;
+
+    for(i = 0; i < lines; i++){
+        logbuf_printf(&raw, "%lu,%lu,%s\n", i, i * 7, "0123456789abcdef");
+        journal_commit(&raw);
+        if(align && rec.reserved != reserved){
+            reserved = rec.reserved;
+            if(!auBoundaryAfter(chainEnd(raw.sclust))){
+                bad++;
+            }
+        }
+        if(i % ACT_EVERY == 0){
+            actLine(s, i / ACT_EVERY);
+            f_write(&act, s, strlen(s), &bw);
+            f_sync(&act);
+        }
+        if(i % EVT_EVERY == 0){
+            evtLine(s, i / EVT_EVERY);
+            f_write(&evt, s, strlen(s), &bw);
+            f_sync(&evt);
+        }
+    }
+    if(align && !auBoundaryAfter(chainEnd(raw.sclust))){
+        bad++;                          // first extent, if the session never extended
+    }
+    logbuf_flush(&raw);
+    journal_close(&raw);
+    f_close(&act);
+    f_close(&evt);
+    f_flush("");
+    if(bad){
+        printf("%s: %lu extents end inside an AU\n", name, bad);
+        failures++;
+    }
+}
+//*********************************************************************************************
+// Every AU the chain enters belongs to it up to the boundary, except the
+// last one that f_truncate() gave back, and its data went out in order.
+static int checkPlacement(const char *name){
+    static BYTE *own;
+    static DWORD *last;
+    DWORD c, n, e, au, s;
+    unsigned long i;
+    int bad = 0;
+    FIL f;
+
+    if(!own){
+        own = malloc(fs.n_fatent);
+        last = malloc((SECTORS / AU_SECTORS + 1) * sizeof(DWORD));
+    }
+    memset(own, 0, fs.n_fatent);
+    if(f_open(&f, name, FA_READ) != FR_OK){
+        return 1;
+    }
+    for(c = f.sclust; c >= 2 && c < fs.n_fatent; c = get_fat(&fs, c)){
+        own[c] = 1;
+    }
+    e = chainEnd(f.sclust);
+    f_close(&f);
+
+    for(c = f.sclust, n = 0; c >= 2 && c < fs.n_fatent; n = c, c = get_fat(&fs, c)){
+        if((c == n + 1 && (c - fs.au0) % fs.au) || (c - fs.au0) / fs.au == (e - fs.au0) / fs.au){
+            continue;                   // inside the AU, or the AU of the end
+        }
+        for(s = c; (s - fs.au0) % fs.au || s == c; s++){
+            if(!own[s]){
+                printf("%s: enters the AU at cluster %lu, cluster %lu is not its own\n", name,
+                       (unsigned long)c, (unsigned long)s);
+                bad++;
+                break;
+            }
+        }
+    }
+
+    memset(last, 0, (SECTORS / AU_SECTORS + 1) * sizeof(DWORD));
+    for(i = 0; i < traced; i++){
+        s = trace[i];
+        c = (s - fs.database) / CLUSTER_SECTORS + 2;
+        if(c >= fs.n_fatent || !own[c]){
+            continue;
+        }
+        au = s / AU_SECTORS;
+        if(s < last[au]){
+            printf("%s: sector %lu written after %lu of the same AU\n", name,
+                   (unsigned long)s, (unsigned long)last[au] - 1);
+            bad++;
+            break;
+        }
+        last[au] = s + 1;
+    }
+    return bad;
+}
+//*********************************************************************************************
+// removed after session 3: RAW files that leave whole AUs free, and ACT and
+// EVT files that leave gaps in AUs a RAW file goes on in
+static const char *const removed[] = {"RAW_02.CSV", "ACT_00.CSV", "EVT_00.CSV", "ACT_01.CSV", "EVT_01.CSV", "ACT_03.CSV"};
+
+static int isRemoved(const char *name){
+    unsigned int i;
+
+    for(i = 0; i < sizeof(removed) / sizeof(removed[0]); i++){
+        if(!strcmp(name, removed[i])) return 1;
+    }
+    return 0;
+}
+//*********************************************************************************************
+// one file of every session, unless it was removed
+static void checkContents(int n, const char *kind, void (*gen)(char *, unsigned long), unsigned long lines){
+    char name[16];
+
+    sprintf(name, "%s_%02d.CSV", kind, n);
+    if(!isRemoved(name) && checkFile(name, gen) != (long)lines){
+        printf("%s: lines missing or wrong\n", name);
+        failures++;
+    }
+}
+//*********************************************************************************************
+// The card was in a PC: files were removed there, and the hint to the next
+// free cluster in FSINFO cleared as some systems leave it. New chains then
+// start at the front of the card, among the gaps.
+static void pcVisit(int align){
+    unsigned int i;
+
+    for(i = 0; i < sizeof(removed) / sizeof(removed[0]); i++){
+        f_unlink(removed[i]);
+    }
+    f_flush("");
+    f_mount(0, "", 0);
+    memset(ramdisk + 512 + 492, 0xFF, 4);       // FSI_Nxt_Free
+    WinCacheFs = 0;                 // both caches belong to the card before the visit
+    GeoCacheFs = 0;
+    memset(&FfWinCache, 0, sizeof(FfWinCache));
+    memset(&FfGeoCache, 0, sizeof(FfGeoCache));
+    f_mount(&fs, "", 1);
+    if(!align){
+        fs.au = 0;
+    }
+}
+//*********************************************************************************************
+static double run(int align){
+    char name[16];
+    DWORD lost;
+    int n;
+
+    start(align);
+    trace = malloc(SECTORS * 2 * sizeof(DWORD));
+    for(n = 0; n < SESSIONS; n++){
+        traced = 0;
+        session(n, sessionLines[n], align);
+        sprintf(name, "RAW_%02d.CSV", n);
+        if(align && checkPlacement(name)){
+            failures++;
+        }
+        if(n == 3){
+            pcVisit(align);
+        }
+    }
+    free(trace);
+    trace = 0;
+
+    for(n = 0; n < SESSIONS; n++){
+        checkContents(n, "RAW", rawLine, sessionLines[n]);
+        checkContents(n, "ACT", actLine, (sessionLines[n] + ACT_EVERY - 1) / ACT_EVERY);
+        checkContents(n, "EVT", evtLine, (sessionLines[n] + EVT_EVERY - 1) / EVT_EVERY);
+    }
+    if(ramdisk_fsck(1, &lost) || lost){
+        failures++;
+    }
+    ramdiskWriteHook = 0;
+
+    printf("%-10s %8.1f %12.2f %10.1f %10.1f\n", align ? "AU" : "no AU", sectors / 2048.0,
+           opens / (sectors / 2048.0), seeks / (sectors / 2048.0), cost / (sectors / 2048.0));
+    return cost / (double)sectors;
+}
+//*********************************************************************************************
+int main(void){
+    double plain, au;
+    int n;
+
+    srand(5);
+    for(n = 0; n < SESSIONS; n++){
+        sessionLines[n] = 20000UL * (3 + rand() % 12);      // about 2 to 10 MB
+    }
+    printf("%-10s %8s %12s %10s %10s\n", "placement", "MB", "AU opens/MB", "seeks/MB", "cost/MB");
+    plain = run(0);
+    au = run(1);
+    if(au >= plain){
+        printf("AU placement costs the card model more than none\n");
+        failures++;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * fmt_check.c
+ *
+ *  Host check of the decimal conversion in logbuf.c against f_printf:
+ *
+ *      gcc -O2 -Wall -Wno-unknown-pragmas -I. -o fmt_check tools/fmt_check.c logbuf.c FatFS/ff.c
+ *      ./fmt_check
+ *
+ *  run in FR5969_MoveH_fw. logbuf_fmt_i16/u16 are compared for every value,
+ *  logbuf_fmt_u32 on a stride over the whole range plus the neighbours of
+ *  each power of ten and of the bounds of the reciprocal paths
+ *  (v * 5243 >> 19, (v >> 4) * 6711 >> 22, v * 0xD1B71759 >> 45).
+ *  Prints the first mismatches and exits with 1 if there is any.
+ *
+ *  f_printf writes into the pool buffer of a FIL that is set up one byte
+ *  into a sector of no cluster, so f_write never reaches the disk functions
+ *  below.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "../logbuf.h"
+#include "../journal.h"
+#include "../FatFS/diskio.h"
+
+// what the application and the disk layer provide on the target
+BYTE FfPool[_FS_BUFPOOL][_MAX_SS];
+FFWINCACHE FfWinCache;
+FFGEOCACHE FfGeoCache;
+
+DSTATUS disk_initialize(BYTE pdrv){ return STA_NOINIT; }
+DSTATUS disk_status(BYTE pdrv){ return 0; }
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count){ return RES_ERROR; }
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count){ return RES_ERROR; }
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff){ return RES_ERROR; }
+DWORD get_fattime(void){ return 0; }
+FRESULT journal_commit(FIL *fp){ return FR_OK; }
+
+static FATFS fs;
+static FIL fil;
+static unsigned long checked = 0, failed = 0;
+
+//*********************************************************************************************
+static void setup(void){
+    fs.fs_type = FS_FAT32;
+    fs.id = 1;
+    fs.csize = 1;
+    fil.fs = &fs;
+    fil.id = 1;
+    fil.flag = FA_WRITE;
+}
+//*********************************************************************************************
+// f_printf output of one conversion, 0-terminated in out
+static void reference(char *out, const char *fmt, uint32_t v){
+    int n;
+
+    fil.fptr = 1;
+    fil.fsize = 1;
+    fil.err = 0;
+    if(fmt[1] == 'l'){
+        n = f_printf(&fil, fmt, (unsigned long)v);
+    }
+    else if(fmt[1] == 'd'){
+        n = f_printf(&fil, fmt, (int)(int16_t)v);
+    }
+    else{
+        n = f_printf(&fil, fmt, (unsigned int)v);
+    }
+    if(n < 0){
+        n = 0;
+    }
+    memcpy(out, fil.buf + 1, n);
+    out[n] = 0;
+}
+//*********************************************************************************************
+static void compare(const char *fmt, uint32_t v){
+    char ref[16], got[16], *end;
+
+    reference(ref, fmt, v);
+    if(fmt[1] == 'l'){
+        end = logbuf_fmt_u32(got, v);
+    }
+    else if(fmt[1] == 'd'){
+        end = logbuf_fmt_i16(got, (int16_t)v);
+    }
+    else{
+        end = logbuf_fmt_u16(got, (uint16_t)v);
+    }
+    *end = 0;
+    checked++;
+    if(strcmp(ref, got)){
+        if(failed < 10){
+            printf("%s %lu: f_printf \"%s\", logbuf \"%s\"\n", fmt, (unsigned long)v, ref, got);
+        }
+        failed++;
+    }
+}
+//*********************************************************************************************
+// v-2..v+2, clipped to the 32 bit range
+static void around(uint32_t v){
+    uint64_t w;
+
+    for(w = (v < 2) ? 0 : v - 2; w <= (uint64_t)v + 2 && w <= 0xFFFFFFFFUL; w++){
+        compare("%lu", (uint32_t)w);
+    }
+}
+//*********************************************************************************************
+int main(void){
+    uint32_t v, p;
+
+    setup();
+    for(v = 0; v <= 0xFFFF; v++){
+        compare("%u", v);
+        compare("%d", v);
+        compare("%lu", v);
+    }
+    for(v = 0x10000; v >= 0x10000; v += 997){      // stops when v wraps
+        compare("%lu", v);
+    }
+    for(p = 10; p <= 1000000000UL; p *= 10){
+        around(p);
+        around(p * 2);
+        around(p * 5);
+    }
+    around(0xFFFFUL * 10000);               // v / 10000 leaves the 16 bit path
+    around(0xFFFFUL * 10000 + 10000);
+    around(429496UL * 10000);
+    around(0xFFFFFFFFUL);
+
+    printf("%lu conversions, %lu differ\n", checked, failed);
+    return failed ? 1 : 0;
+}
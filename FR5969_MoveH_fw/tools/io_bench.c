@@ -0,0 +1,162 @@
+/*
+ * io_bench.c
+ *
+ *  Host benchmark of the session file write path on a RAM disk: the sample
+ *  lines written with f_printf() as before logbuf.c, against the same lines
+ *  encoded into the FRAM sector block by channels_write_sample():
+ *
+ *      gcc -O2 -Wall -Wno-unknown-pragmas -I. -Itools -o io_bench tools/io_bench.c tools/ramdisk.c
+ *      ./io_bench
+ *
+ *  run in FR5969_MoveH_fw. Both runs write SAMPLES samples with all channels
+ *  into a session file pre-extended by journal_open() and commit the journal
+ *  every RING_DRAIN samples, as taskWrite() does. The table gives f_write
+ *  calls and bytes copied into the FIL buffer per sample, the sectors read
+ *  into the buffer before a partial write (FfStats), and the sectors read
+ *  and written on the card. Exits with 1 if the two files differ.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ramdisk.h"
+#include "../FatFS/ff.c"
+#include "../journal.c"
+#include "../logbuf.c"
+#include "../channels.c"
+
+#define SECTORS         70000UL     // FAT32 needs 65525 clusters
+#define AU_SECTORS      2048UL
+#define CLUSTER_SECTORS 1
+#define SAMPLES         2000
+#define RING_DRAIN      8           // samples per taskWrite()
+
+unsigned char RX_Data[23];          // burst buffer of icm20948.c, not used here
+
+static FATFS fs;
+static FIL fil;
+static sample_t samples[SAMPLES];
+
+//*********************************************************************************************
+// channels_write_sample() before logbuf.c
+static void printfSample(FIL *fp, const sample_t *smp){
+    const char *sep = "";
+
+    if(channelMask & CH_TIME){
+        f_printf(fp, "%lu", smp->time);
+        sep = ",";
+    }
+    if(channelMask & CH_ACCEL){
+        f_printf(fp, "%s%d,%d,%d", sep, smp->xAccel, smp->yAccel, smp->zAccel);
+        sep = ",";
+    }
+    if(channelMask & CH_GYRO){
+        f_printf(fp, "%s%d,%d,%d", sep, smp->xGyro, smp->yGyro, smp->zGyro);
+        sep = ",";
+    }
+    if(channelMask & CH_TEMP){
+        f_printf(fp, "%s%d", sep, smp->temp);
+        sep = ",";
+    }
+    if(channelMask & CH_MAG){
+        f_printf(fp, "%s%d,%d,%d", sep, smp->xMag, smp->yMag, smp->zMag);
+        sep = ",";
+    }
+    if(channelMask & CH_QUAT){
+        f_printf(fp, "%s%d,%d,%d,%d", sep, smp->q[0], smp->q[1], smp->q[2], smp->q[3]);
+    }
+    f_putc('\n', fp);
+}
+//*********************************************************************************************
+// one session into name, the table row for it
+static void run(const char *name, int direct){
+    DWORD reads, writes;
+    int i;
+
+    memset(&FfStats, 0, sizeof(FfStats));
+    reads = ramdiskReads;
+    writes = ramdiskWrites;
+
+    f_open(&fil, name, FA_WRITE | FA_CREATE_ALWAYS);
+    journal_open(&fil, name);
+    if(direct){
+        logbuf_open(&fil);
+    }
+    for(i = 0; i < SAMPLES; i++){
+        if(direct){
+            channels_write_sample(&fil, &samples[i]);
+        }
+        else{
+            printfSample(&fil, &samples[i]);
+        }
+        if(i % RING_DRAIN == RING_DRAIN - 1){
+            journal_commit(&fil);
+        }
+    }
+    if(direct){
+        logbuf_flush(&fil);
+    }
+    journal_close(&fil);
+    f_flush("");
+
+    printf("%-10s %14.2f %15.1f %10lu %7lu/%lu\n", direct ? "logbuf" : "f_printf",
+           (double)FfStats.writes / SAMPLES, (double)FfStats.copied / SAMPLES, (unsigned long)FfStats.fills,
+           (unsigned long)(ramdiskReads - reads), (unsigned long)(ramdiskWrites - writes));
+}
+//*********************************************************************************************
+// 1 if the files differ
+static int compare(const char *a, const char *b){
+    static BYTE bufA[4096], bufB[4096];
+    FIL fa, fb;
+    UINT na, nb;
+    int differ = 0;
+
+    f_open(&fa, a, FA_READ);
+    f_open(&fb, b, FA_READ);
+    do{
+        f_read(&fa, bufA, sizeof(bufA), &na);
+        f_read(&fb, bufB, sizeof(bufB), &nb);
+        if(na != nb || memcmp(bufA, bufB, na)){
+            differ = 1;
+        }
+    }while(na && !differ);
+    f_close(&fa);
+    f_close(&fb);
+    return differ;
+}
+//*********************************************************************************************
+int main(void){
+    int i, differ;
+
+    srand(41);
+    for(i = 0; i < SAMPLES; i++){
+        samples[i].time = 100000UL + 5UL * i;
+        samples[i].xAccel = (int16_t)rand();
+        samples[i].yAccel = (int16_t)rand();
+        samples[i].zAccel = (int16_t)rand();
+        samples[i].xGyro = (int16_t)rand();
+        samples[i].yGyro = (int16_t)rand();
+        samples[i].zGyro = (int16_t)rand();
+        samples[i].temp = (int16_t)(rand() % 4000);
+        samples[i].xMag = (int16_t)(rand() % 2000 - 1000);
+        samples[i].yMag = (int16_t)(rand() % 2000 - 1000);
+        samples[i].zMag = (int16_t)(rand() % 2000 - 1000);
+        samples[i].q[0] = (int16_t)(rand() % 32768 - 16384);
+        samples[i].q[1] = (int16_t)(rand() % 32768 - 16384);
+        samples[i].q[2] = (int16_t)(rand() % 32768 - 16384);
+        samples[i].q[3] = (int16_t)(rand() % 32768 - 16384);
+    }
+    channels_set("sagtmq");
+    channels_layout(0);
+
+    ramdisk_init(SECTORS, AU_SECTORS);
+    ramdisk_format(CLUSTER_SECTORS, 0x494F4245);
+    f_mount(&fs, "", 1);
+
+    printf("%-10s %14s %15s %10s %12s\n", "", "f_write/sample", "copied B/sample", "read-fills", "sectors r/w");
+    run("RAW_00.CSV", 0);
+    run("RAW_01.CSV", 1);
+    differ = compare("RAW_00.CSV", "RAW_01.CSV");
+    printf("%lu bytes per file, %s\n", (unsigned long)fil.fsize, differ ? "files differ, FAILED" : "files identical");
+    return differ;
+}
@@ -0,0 +1,419 @@
+/*
+ * journal_check.c
+ *
+ *  Power-loss and fault-injection check of the session journal (journal.c)
+ *  and the FRAM sector block (logbuf.c) on a RAM disk:
+ *
+ *      gcc -O2 -Wall -Wno-unknown-pragmas -I. -Itools -o journal_check tools/journal_check.c tools/ramdisk.c
+ *      ./journal_check
+ *
+ *  run in FR5969_MoveH_fw. The firmware sources are included, so the SRAM
+ *  state of ff.c and journal.c can be cleared for a simulated reboot while
+ *  the FRAM state (commit slots, sector block, FAT cache) stays.
+ *
+ *  power loss   A session of numbered lines is cut off after n sector
+ *               writes, for every write that touches the FAT, FSINFO or the
+ *               directory, the writes next to them and a stride through
+ *               the data. After the reboot and journal_recover() the file
+ *               must hold exactly the lines written before the cut, and the
+ *               volume must pass the fsck in ramdisk.c. Clusters lost by
+ *               the cut may not exceed one extent, LOST_MAX.
+ *  recovery     The same, with a second power loss during the recovery.
+ *  torn slot    A commit record torn after every byte, or with any single
+ *               bit flipped, must fall back to the other slot; sequence
+ *               numbers wrap around.
+ *  cloned card  FAT sectors a cut left in the FRAM cache must not reach
+ *               another card with the same volume serial number.
+ *
+ *  Exits with 1 if a case fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ramdisk.h"
+#include "../FatFS/ff.c"
+#include "../journal.c"
+#include "../logbuf.c"
+
+#define SECTORS         70000UL     // FAT32 needs 65525 clusters
+#define AU_SECTORS      2048UL      // 1 MB allocation units
+#define LINES           120000UL    // about 5 MB, one extension of the extent
+#define DATA_STRIDE     101         // cut points between metadata writes
+#define RECOVERY_CASES  6           // cut states that get a second power loss
+#define CLUSTER_SECTORS 1
+#define LOST_MAX        ((JOURNAL_RESERVE / 512 + AU_SECTORS) / CLUSTER_SECTORS)   // one extent
+
+static FATFS fs;
+static FIL fil;
+static BYTE *metaMap;               // 1 for sectors of FAT, FSINFO, boot sector and root directory
+static unsigned long linesDone;     // logbuf_printf calls that returned
+static int failures = 0;
+static DWORD lostMax = 0, lostCuts = 0;     // clusters lost by a cut, see ramdisk_fsck()
+
+// FRAM of a simulated power loss, see saveState()
+typedef struct {
+    journal_rec_t slots[2];
+    FFWINCACHE winCache;
+    FFGEOCACHE geoCache;
+    char block[sizeof(block)];
+    logbuf_state_t state;
+    BYTE *image;
+    unsigned long lines;            // linesDone at the cut, not FRAM
+} fram_t;
+
+//*********************************************************************************************
+// SRAM is gone, FRAM keeps its contents
+static void reboot(void){
+    memset(&fs, 0, sizeof(fs));
+    memset(&fil, 0, sizeof(fil));
+    Fsid = 0;
+    memset(PoolOwner, 0, sizeof(PoolOwner));
+    memset(PoolUse, 0, sizeof(PoolUse));
+    PoolClock = 0;
+    WinCacheFs = 0;
+    GeoCacheFs = 0;
+    memset(&rec, 0, sizeof(rec));
+    active = 0;
+    line = block;
+}
+//*********************************************************************************************
+// a card fresh from the formatter in a logger that never ran
+static void freshFram(void){
+    memset(journalSlot, 0, sizeof(journalSlot));
+    memset(&FfWinCache, 0, sizeof(FfWinCache));
+    memset(&FfGeoCache, 0, sizeof(FfGeoCache));
+    memset(block, 0, sizeof(block));
+    state.base = 0;
+    state.limit = _MAX_SS;
+    state.len = 0;
+    state.done = 0;
+}
+//*********************************************************************************************
+static void saveState(fram_t *f){
+    memcpy(f->slots, journalSlot, sizeof(journalSlot));
+    f->winCache = FfWinCache;
+    f->geoCache = FfGeoCache;
+    memcpy(f->block, block, sizeof(block));
+    memcpy(&f->state, (const void *)&state, sizeof(state));
+    if(!f->image){
+        f->image = malloc(SECTORS * 512);
+    }
+    memcpy(f->image, ramdisk, SECTORS * 512);
+    f->lines = linesDone;
+}
+//*********************************************************************************************
+static void loadState(const fram_t *f){
+    memcpy(journalSlot, f->slots, sizeof(journalSlot));
+    FfWinCache = f->winCache;
+    FfGeoCache = f->geoCache;
+    memcpy(block, f->block, sizeof(block));
+    memcpy((void *)&state, &f->state, sizeof(state));
+    memcpy(ramdisk, f->image, SECTORS * 512);
+    linesDone = f->lines;
+}
+//*********************************************************************************************
+// boot as main() does it: mount, repair an interrupted session, write the cache
+static FRESULT boot(void){
+    FRESULT fr;
+
+    reboot();
+    fr = f_mount(&fs, "", 1);
+    if(fr == FR_OK) fr = journal_recover(&fil);
+    if(fr == FR_OK) fr = f_flush("");
+    return fr;
+}
+//*********************************************************************************************
+// startMeasurement(), the sample lines and stopMeasurement() without the other files
+static void session(const char *name, unsigned long lines){
+    unsigned long i;
+
+    linesDone = 0;
+    f_open(&fil, name, FA_WRITE | FA_OPEN_ALWAYS | FA_ALIGN);
+    journal_open(&fil, name);
+    logbuf_open(&fil);
+    for(i = 0; i < lines; i++){
+        logbuf_printf(&fil, "%lu,%lu,%s\n", i, i * 7, "0123456789abcdef");
+        linesDone++;
+        journal_commit(&fil);
+    }
+    logbuf_flush(&fil);
+    journal_close(&fil);
+    f_flush("");
+}
+//*********************************************************************************************
+// lines in the file, -1 if one of them is not the next in order
+static long countLines(const char *name){
+    static char buf[4096];
+    char expect[64], part[64];
+    FIL f;
+    UINT br, i, n = 0;
+    long count = 0;
+
+    if(f_open(&f, name, FA_READ) != FR_OK){
+        return 0;
+    }
+    sprintf(expect, "%lu,%lu,%s\n", 0UL, 0UL, "0123456789abcdef");
+    while(f_read(&f, buf, sizeof(buf), &br) == FR_OK && br){
+        for(i = 0; i < br; i++){
+            if(n >= sizeof(part) - 1 || buf[i] != expect[n]){
+                f_close(&f);
+                return -1;
+            }
+            part[n++] = buf[i];
+            if(buf[i] == '\n'){
+                count++;
+                sprintf(expect, "%lu,%lu,%s\n", (unsigned long)count, (unsigned long)count * 7, "0123456789abcdef");
+                n = 0;
+            }
+        }
+    }
+    f_close(&f);
+    return n ? -1 : count;
+}
+//*********************************************************************************************
+// after the reboot: every line completed before the cut, the last one may
+// have been completed by the write that was cut
+static int verify(const char *what, long cut){
+    long lines = countLines("RAW_00.CSV");
+    DWORD lost;
+    int problems = ramdisk_fsck(0, &lost);
+
+    if(lost){
+        lostCuts++;
+        if(lost > lostMax) lostMax = lost;
+    }
+    if(lines < (long)linesDone || lines > (long)linesDone + 1 || problems || lost > LOST_MAX){
+        if(failures < 10 || getenv("ALL")){
+            printf("%s, cut at write %ld: %ld lines of %lu, fsck %d\n", what, cut, lines, linesDone, problems);
+            ramdisk_fsck(1, &lost);
+        }
+        failures++;
+        return 0;
+    }
+    return 1;
+}
+//*********************************************************************************************
+// sectors that are not file data, after ramdisk_format()
+static void mapMetadata(void){
+    DWORD rsvd = ramdisk[14] | ramdisk[15] << 8;
+    DWORD fatsz = ramdisk[36] | ramdisk[37] << 8 | (DWORD)ramdisk[38] << 16;
+
+    metaMap = calloc(SECTORS, 1);
+    memset(metaMap, 1, rsvd + 2 * fatsz + 1);       // up to the root directory cluster
+}
+//*********************************************************************************************
+static DWORD writeNo;               // sector writes since the cut was armed
+static BYTE *metaWrite;             // 1 for the numbers of writes that hit metadata
+
+static void countWrite(DWORD sector, UINT count){
+    UINT i;
+
+    for(i = 0; i < count; i++, writeNo++){
+        if(metaMap[sector + i]){
+            metaWrite[writeNo] = 1;
+        }
+    }
+}
+//*********************************************************************************************
+static int isCutPoint(DWORD n, DWORD total){
+    return n % DATA_STRIDE == 0 || metaWrite[n] || (n && metaWrite[n - 1]) || (n + 1 < total && metaWrite[n + 1]) || n + 1 == total;
+}
+//*********************************************************************************************
+// run fn with the power failing after cut sector writes; the setjmp is kept
+// out of the callers so their loop variables cannot be clobbered
+static void powerFailsIn(long cut, void (*fn)(void)){
+    if(setjmp(ramdiskPowerFail) == 0){
+        ramdiskCut = cut;
+        fn();
+    }
+    ramdiskCut = -1;
+}
+static void cutSession(void){
+    session("RAW_00.CSV", LINES);
+}
+static void cutBoot(void){
+    boot();
+}
+//*********************************************************************************************
+static void powerLoss(fram_t *cases){
+    DWORD total, n, runs = 0, saved = 0, lost;
+    long cut;
+
+    // dry run: which writes hit metadata
+    freshFram();
+    ramdisk_restore();
+    boot();
+    writeNo = 0;
+    metaWrite = calloc(4 * LINES, 1);
+    ramdiskWriteHook = countWrite;
+    session("RAW_00.CSV", LINES);
+    ramdiskWriteHook = 0;
+    total = writeNo;
+    if(countLines("RAW_00.CSV") != LINES || ramdisk_fsck(1, &lost) || lost){
+        printf("power loss: the session without a cut is already wrong\n");
+        failures++;
+        return;
+    }
+
+    for(n = 0; n < total; n++){
+        if(!isCutPoint(n, total)){
+            continue;
+        }
+        freshFram();
+        ramdisk_restore();
+        boot();
+        cut = (long)n;
+        powerFailsIn(cut, cutSession);
+        runs++;
+        if(saved < RECOVERY_CASES && n >= total / RECOVERY_CASES * saved && n > 0){
+            saveState(&cases[saved++]);
+        }
+        if(boot() != FR_OK){
+            printf("power loss, cut at write %ld: no mount\n", cut);
+            failures++;
+            continue;
+        }
+        verify("power loss", cut);
+    }
+    printf("power loss: %lu cuts of %lu writes\n", (unsigned long)runs, (unsigned long)total);
+}
+//*********************************************************************************************
+// a second power loss at every write of journal_recover() and f_flush()
+static void recovery(fram_t *cases){
+    DWORD writes, r, runs = 0;
+    int i;
+
+    for(i = 0; i < RECOVERY_CASES && cases[i].image; i++){
+        loadState(&cases[i]);
+        writes = ramdiskWrites;
+        boot();
+        writes = ramdiskWrites - writes;
+        for(r = 0; r < writes; r++){
+            loadState(&cases[i]);
+            powerFailsIn((long)r, cutBoot);
+            runs++;
+            linesDone = cases[i].lines;
+            if(boot() != FR_OK){
+                printf("recovery, cut at write %lu: no mount\n", (unsigned long)r);
+                failures++;
+                continue;
+            }
+            verify("recovery", (long)r);
+        }
+    }
+    printf("recovery: %lu cuts\n", (unsigned long)runs);
+}
+//*********************************************************************************************
+// commit with rec.committed = value, returns the slot it went to
+static uint8_t commitValue(uint32_t value){
+    rec.committed = value;
+    writeRecord();
+    return active;
+}
+//*********************************************************************************************
+static void tornSlot(void){
+    journal_rec_t before, after;
+    unsigned int k, bit, runs = 0;
+    uint8_t slot;
+    uint16_t seq;
+
+    for(seq = 0xFFF0; seq != 0x0010; seq++){        // across the wrap of seq
+        memset(journalSlot, 0, sizeof(journalSlot));
+        memset(&rec, 0, sizeof(rec));
+        active = 0;
+        rec.seq = seq;
+        rec.state = JOURNAL_OPEN;
+        commitValue(1000);
+        commitValue(2000);
+        if(!loadNewest() || rec.committed != 2000){
+            printf("torn slot: seq %u: newest slot not found\n", seq);
+            failures++;
+        }
+
+        // third commit, torn after k bytes, into the slot holding 1000
+        slot = active ^ 1;
+        before = journalSlot[slot];
+        rec.committed = 3000;
+        rec.magic = JOURNAL_MAGIC;
+        rec.seq++;
+        rec.crc = crc16((const uint8_t *)&rec, offsetof(journal_rec_t, crc));
+        after = rec;
+        for(k = 0; k <= sizeof(journal_rec_t); k++){
+            journalSlot[slot] = before;
+            memcpy(&journalSlot[slot], &after, k);
+            loadNewest();
+            if(rec.committed != (memcmp(&journalSlot[slot], &after, sizeof(after)) ? 2000 : 3000)){
+                printf("torn slot: seq %u, torn after %u bytes: committed %lu\n", seq, k, (unsigned long)rec.committed);
+                failures++;
+            }
+            runs++;
+        }
+        // the complete record with one bit flipped
+        for(bit = 0; bit < 8 * sizeof(journal_rec_t); bit++){
+            journalSlot[slot] = after;
+            ((uint8_t *)&journalSlot[slot])[bit / 8] ^= 1 << (bit % 8);
+            loadNewest();
+            if(rec.committed != 2000){
+                printf("torn slot: seq %u, bit %u flipped: committed %lu\n", seq, bit, (unsigned long)rec.committed);
+                failures++;
+            }
+            runs++;
+        }
+    }
+    memset(journalSlot, 0xA5, sizeof(journalSlot));
+    if(loadNewest()){
+        printf("torn slot: garbage taken for a record\n");
+        failures++;
+    }
+    printf("torn slot: %u records\n", runs);
+}
+//*********************************************************************************************
+// Cards written from one image share serial number and FAT start, only the
+// CID tells them apart.
+static void clonedCard(void){
+    BYTE *clone = malloc(SECTORS * 512);
+    int i, dirty = 0;
+
+    freshFram();
+    ramdisk_restore();
+    boot();
+    powerFailsIn(3000, cutSession);
+    for(i = 0; i < _FS_WINCACHE; i++){
+        dirty += FfWinCache.dirty[i];
+    }
+    ramdisk_restore();              // the clone, fresh from the image
+    memcpy(clone, ramdisk, SECTORS * 512);
+    ramdiskCid = 0x5B;
+    boot();
+    ramdiskCid = 0x5A;
+    if(!dirty){
+        printf("cloned card: no dirty sectors in the cache to test with\n");
+        failures++;
+    }
+    else if(memcmp(clone, ramdisk, SECTORS * 512)){
+        printf("cloned card: the cache of the other card was written to it\n");
+        failures++;
+    }
+    printf("cloned card: %d dirty sectors in the cache\n", dirty);
+    free(clone);
+}
+//*********************************************************************************************
+int main(void){
+    static fram_t cases[RECOVERY_CASES];
+
+    ramdisk_init(SECTORS, AU_SECTORS);
+    ramdisk_format(CLUSTER_SECTORS, 0x4A430001);
+    mapMetadata();
+    ramdisk_snapshot();
+
+    tornSlot();
+    powerLoss(cases);
+    recovery(cases);
+    clonedCard();
+    printf("lost clusters: %lu cuts, at most %lu, LOST_MAX %lu\n",
+           (unsigned long)lostCuts, (unsigned long)lostMax, (unsigned long)LOST_MAX);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
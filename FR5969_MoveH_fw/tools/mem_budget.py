@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+#
+# mem_budget.py
+#
+#  SRAM and FRAM budget from the linker map file of a CCS build:
+#
+#      python3 tools/mem_budget.py Release/FR5969_MoveH_fw.map
+#
+#  Lists the data sections with their largest contributors and what is
+#  left of the 2 KB SRAM. Exits with 1 when less than --min-free bytes of
+#  SRAM are unused, so it can run as a post-build step.
+#
+
+import argparse
+import re
+import sys
+
+# output sections that hold data, and where they live
+DATA_SECTIONS = [
+    ('.bss', 'RAM'),
+    ('.data', 'RAM'),
+    ('.TI.noinit', 'RAM'),
+    ('.stack', 'RAM'),
+    ('.TI.persistent', 'FRAM'),
+    ('.fram_buffers', 'FRAM'),
+    ('.sysmem', 'FRAM'),
+    ('.cio', 'FRAM'),
+]
+
+MEMORY_RE = re.compile(r'^\s+(\w+)\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s+([0-9a-f]{8})')
+OUTPUT_RE = re.compile(r'^(\S+)?\s+\d+\s+([0-9a-f]{8})\s+([0-9a-f]{8})')
+INPUT_RE = re.compile(r'^\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s+(.*)$')
+
+
+def parse(path):
+    memory = {}
+    sections = {}
+    state = None
+    current = None
+    pending = None
+
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if line.startswith('MEMORY CONFIGURATION'):
+                state = 'memory'
+                continue
+            if line.startswith('SECTION ALLOCATION MAP'):
+                state = 'sections'
+                continue
+            if line.startswith('SEGMENT ALLOCATION MAP') or line.startswith('LINKER GENERATED'):
+                state = None
+                continue
+
+            if state == 'memory':
+                m = MEMORY_RE.match(line)
+                if m:
+                    memory[m.group(1)] = (int(m.group(3), 16), int(m.group(4), 16))
+            elif state == 'sections':
+                if line and not line[0].isspace() and not line.startswith('*'):
+                    name = line.split()[0]
+                    m = OUTPUT_RE.match(line)
+                    if m:
+                        current = sections.setdefault(name, [int(m.group(3), 16), []])
+                        pending = None
+                    else:                               # long name, numbers follow on a '*' line
+                        pending = name
+                    continue
+                if line.startswith('*') and pending:
+                    m = OUTPUT_RE.match(line[1:])
+                    if m:
+                        current = sections.setdefault(pending, [int(m.group(3), 16), []])
+                    pending = None
+                    continue
+                m = INPUT_RE.match(line)
+                if m and current is not None:
+                    what = m.group(3).strip()
+                    if not what.startswith('--HOLE--'):
+                        current[1].append((int(m.group(2), 16), what))
+    return memory, sections
+
+
+def main():
+    ap = argparse.ArgumentParser(description='SRAM/FRAM budget from a cl430 map file')
+    ap.add_argument('map')
+    ap.add_argument('--top', type=int, default=5, help='contributors listed per section')
+    ap.add_argument('--min-free', type=int, default=0, help='SRAM bytes that must stay unused')
+    args = ap.parse_args()
+
+    memory, sections = parse(args.map)
+    if 'RAM' not in memory:
+        sys.exit('%s: no MEMORY CONFIGURATION table' % args.map)
+
+    print('%-16s %-5s %6s' % ('section', 'mem', 'bytes'))
+    for name, mem in DATA_SECTIONS:
+        if name not in sections:
+            continue
+        size, parts = sections[name]
+        print('%-16s %-5s %6d' % (name, mem, size))
+        for psize, what in sorted(parts, reverse=True)[:args.top]:
+            if psize:
+                print('    %6d  %s' % (psize, what))
+
+    print()
+    for mem in ('RAM', 'FRAM'):
+        length, used = memory[mem]
+        print('%-5s %6d used of %6d, %6d free' % (mem, used, length, length - used))
+
+    length, used = memory['RAM']
+    if length - used < args.min_free:
+        print('SRAM budget exceeded: %d bytes free, %d required' % (length - used, args.min_free))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
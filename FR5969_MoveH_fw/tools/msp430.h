@@ -0,0 +1,45 @@
+/*
+ * msp430.h
+ *
+ *  Host stand-in for the device header, found first with -Itools. Only
+ *  the CRC16 module is modelled (journal.c): CRCINIRES and CRCDI_L are
+ *  lvalues, each access first folds the byte written to CRCDI_L before it.
+ *  The CRC is CCITT, MSB first; the check only needs it to be a CRC16.
+ */
+
+#ifndef HOST_MSP430_H_
+#define HOST_MSP430_H_
+
+#include <stdint.h>
+
+static uint16_t hostCrc;
+static uint8_t hostCrcIn;
+static int hostCrcPending = 0;
+
+static inline void hostCrcFold(void){
+    int i;
+
+    if(hostCrcPending){
+        hostCrc ^= (uint16_t)hostCrcIn << 8;
+        for(i = 0; i < 8; i++){
+            hostCrc = (hostCrc & 0x8000) ? (uint16_t)(hostCrc << 1) ^ 0x1021 : (uint16_t)(hostCrc << 1);
+        }
+        hostCrcPending = 0;
+    }
+}
+
+static inline uint16_t *hostCrcRes(void){
+    hostCrcFold();
+    return &hostCrc;
+}
+
+static inline uint8_t *hostCrcDi(void){
+    hostCrcFold();
+    hostCrcPending = 1;
+    return &hostCrcIn;
+}
+
+#define CRCINIRES           (*hostCrcRes())
+#define CRCDI_L             (*hostCrcDi())
+
+#endif /* HOST_MSP430_H_ */
@@ -0,0 +1,248 @@
+/*
+ * pool_check.c
+ *
+ *  Stress check of the sector buffer pool in ff.c (lease_buf(), return_buf(),
+ *  f_lease(), f_release()) on a RAM disk, for pool sizes 1, 2 and 3:
+ *
+ *      for n in 1 2 3; do gcc -O2 -Wall -Wno-unknown-pragmas -D_FS_BUFPOOL=$n -I. -Itools -o pool_check tools/pool_check.c tools/ramdisk.c && ./pool_check || break; done
+ *
+ *  run in FR5969_MoveH_fw. FILES files are open at once and get OPS random
+ *  operations: appends of 0..1500 bytes, overwrites and reads at random
+ *  positions, f_sync, f_lease, f_release, truncation and close/reopen, so
+ *  buffers are taken from dirty and clean files all the time. Every read
+ *  must match a reference copy in host memory, and after every operation
+ *  the pool must be consistent: a file's buffer is a pool buffer owned by
+ *  it and by no other file, and a dirty file holds its buffer. At the end
+ *  the files are reopened and compared in full, and the volume must pass
+ *  the fsck in ramdisk.c. Exits with 1 if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ramdisk.h"
+#include "../FatFS/ff.c"
+
+#define SECTORS         70000UL     // FAT32 needs 65525 clusters
+#define AU_SECTORS      2048UL
+#define CLUSTER_SECTORS 1
+#define FILES           4
+#define OPS             200000UL
+#define MAX_BYTES       (192UL * 1024)  // a longer file is truncated
+#define MAX_CHUNK       1500
+
+static FATFS fs;
+static FIL fil[FILES];
+static BYTE *ref[FILES];            // expected contents
+static DWORD refSize[FILES];
+static BYTE chunk[MAX_CHUNK];
+static unsigned long reads, readBytes;
+static int failures = 0;
+
+//*********************************************************************************************
+static void fail(unsigned long op, int f, const char *what){
+    printf("op %lu, file %d: %s\n", op, f, what);
+    failures++;
+}
+//*********************************************************************************************
+static void name(int f, char *buf){
+    sprintf(buf, "POOL_%d.BIN", f);
+}
+//*********************************************************************************************
+static DWORD randRange(DWORD n){
+    return n ? (DWORD)(((unsigned long)rand() << 15 ^ rand()) % n) : 0;
+}
+//*********************************************************************************************
+// FIL buffers against PoolOwner, see the header
+static int poolBroken(void){
+    int f, g, i, held;
+
+    for(f = 0; f < FILES; f++){
+        if(!fil[f].fs){
+            continue;
+        }
+        if((fil[f].flag & FA__DIRTY) && !fil[f].buf){
+            return 1;
+        }
+        if(!fil[f].buf){
+            continue;
+        }
+        held = 0;
+        for(i = 0; i < _FS_BUFPOOL; i++){
+            if(fil[f].buf == FfPool[i] && PoolOwner[i] == &fil[f]){
+                held++;
+            }
+        }
+        if(held != 1){
+            return 1;
+        }
+        for(g = f + 1; g < FILES; g++){
+            if(fil[g].fs && fil[g].buf == fil[f].buf){
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+//*********************************************************************************************
+static void openFile(int f, BYTE mode){
+    char buf[16];
+
+    name(f, buf);
+    if(f_open(&fil[f], buf, FA_READ | FA_WRITE | mode) != FR_OK){
+        fail(0, f, "open failed");
+        exit(1);
+    }
+}
+//*********************************************************************************************
+static void writeAt(unsigned long op, int f, DWORD pos, UINT n){
+    UINT i, bw;
+
+    for(i = 0; i < n; i++){
+        chunk[i] = (BYTE)rand();
+    }
+    if(f_lseek(&fil[f], pos) != FR_OK || f_write(&fil[f], chunk, n, &bw) != FR_OK || bw != n){
+        fail(op, f, "write failed");
+        return;
+    }
+    memcpy(ref[f] + pos, chunk, n);
+    if(pos + n > refSize[f]){
+        refSize[f] = pos + n;
+    }
+}
+//*********************************************************************************************
+static void readAt(unsigned long op, int f, DWORD pos, UINT n){
+    UINT br;
+
+    if(f_lseek(&fil[f], pos) != FR_OK || f_read(&fil[f], chunk, n, &br) != FR_OK){
+        fail(op, f, "read failed");
+        return;
+    }
+    if(br != n || memcmp(chunk, ref[f] + pos, n)){
+        fail(op, f, "read back differs");
+    }
+    reads++;
+    readBytes += n;
+}
+//*********************************************************************************************
+static void step(unsigned long op){
+    int f = rand() % FILES;
+    int r = rand() % 100;
+    DWORD pos;
+    UINT n;
+
+    if(r < 35){                                         // append
+        n = randRange(MAX_CHUNK + 1);
+        if(refSize[f] + n > MAX_BYTES){
+            pos = randRange(refSize[f] + 1);
+            if(f_lseek(&fil[f], pos) != FR_OK || f_truncate(&fil[f]) != FR_OK){
+                fail(op, f, "truncate failed");
+            }
+            refSize[f] = pos;
+        }
+        writeAt(op, f, refSize[f], n);
+    }
+    else if(r < 50){                                    // overwrite inside the file
+        if(refSize[f]){
+            pos = randRange(refSize[f]);
+            n = 1 + randRange(600);
+            if(pos + n > MAX_BYTES){
+                n = MAX_BYTES - pos;
+            }
+            writeAt(op, f, pos, n);
+        }
+    }
+    else if(r < 78){                                    // read back
+        if(refSize[f]){
+            pos = randRange(refSize[f]);
+            n = 1 + randRange(MAX_CHUNK);
+            if(pos + n > refSize[f]){
+                n = refSize[f] - pos;
+            }
+            readAt(op, f, pos, n);
+        }
+    }
+    else if(r < 86){
+        if(f_release(&fil[f]) != FR_OK){
+            fail(op, f, "f_release failed");
+        }
+    }
+    else if(r < 91){
+        if(f_lease(&fil[f]) != FR_OK){
+            fail(op, f, "f_lease failed");
+        }
+    }
+    else if(r < 98){
+        if(f_sync(&fil[f]) != FR_OK){
+            fail(op, f, "f_sync failed");
+        }
+    }
+    else{                                               // close and reopen
+        if(f_close(&fil[f]) != FR_OK){
+            fail(op, f, "close failed");
+        }
+        openFile(f, FA_OPEN_EXISTING);
+    }
+
+    if(poolBroken()){
+        fail(op, f, "pool inconsistent");
+    }
+    if(fil[f].fsize != refSize[f]){
+        fail(op, f, "size differs");
+    }
+}
+//*********************************************************************************************
+int main(void){
+    unsigned long op;
+    DWORD pos, lost;
+    int f;
+
+    ramdisk_init(SECTORS, AU_SECTORS);
+    ramdisk_format(CLUSTER_SECTORS, 0x504F4F4C);
+    if(f_mount(&fs, "", 1) != FR_OK){
+        printf("mount failed\n");
+        return 1;
+    }
+    srand(_FS_BUFPOOL);
+    for(f = 0; f < FILES; f++){
+        ref[f] = malloc(MAX_BYTES);
+        refSize[f] = 0;
+        openFile(f, FA_CREATE_ALWAYS);
+    }
+
+    for(op = 0; op < OPS && failures < 10; op++){
+        step(op);
+    }
+
+    for(f = 0; f < FILES; f++){
+        if(f_close(&fil[f]) != FR_OK){
+            fail(op, f, "close failed");
+        }
+    }
+    for(f = 0; f < _FS_BUFPOOL; f++){
+        if(PoolOwner[f]){
+            fail(op, -1, "pool buffer held after close");
+        }
+    }
+    for(f = 0; f < FILES; f++){
+        openFile(f, FA_OPEN_EXISTING);
+        if(fil[f].fsize != refSize[f]){
+            fail(op, f, "size differs after reopen");
+        }
+        else if(refSize[f]){
+            for(pos = 0; pos < refSize[f]; pos += MAX_CHUNK){
+                readAt(op, f, pos, refSize[f] - pos < MAX_CHUNK ? refSize[f] - pos : MAX_CHUNK);
+            }
+        }
+        f_close(&fil[f]);
+        free(ref[f]);
+    }
+    f_flush("");
+    if(ramdisk_fsck(1, &lost) || lost){
+        failures++;
+    }
+
+    printf("pool %d: %lu ops, %lu reads (%lu bytes) compared, %lu evictions, %s\n", _FS_BUFPOOL,
+           op, reads, readBytes, (unsigned long)FfStats.evicts, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * ramdisk.c
+ *
+ *  SD card in host memory, see ramdisk.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ramdisk.h"
+#include "../FatFS/diskio.h"
+
+// what main_SD.c provides to ff.c on the target, in FRAM there
+BYTE FfPool[_FS_BUFPOOL][_MAX_SS];
+FFWINCACHE FfWinCache;
+FFGEOCACHE FfGeoCache;
+
+BYTE *ramdisk = 0;
+DWORD ramdiskSectors = 0;
+DWORD ramdiskAu = 0;
+BYTE ramdiskCid = 0x5A;
+DWORD ramdiskReads = 0, ramdiskWrites = 0;
+long ramdiskCut = -1;
+jmp_buf ramdiskPowerFail;
+void (*ramdiskWriteHook)(DWORD sector, UINT count) = 0;
+
+static BYTE *snap = 0;                  // image at ramdisk_snapshot()
+static BYTE *touched = 0;               // sectors written since, one byte each
+static DWORD fattime = 0;
+
+//*********************************************************************************************
+static DWORD ld32(const BYTE *p){
+    return p[0] | (DWORD)p[1] << 8 | (DWORD)p[2] << 16 | (DWORD)p[3] << 24;
+}
+//*********************************************************************************************
+static void st16(BYTE *p, WORD v){
+    p[0] = (BYTE)v;
+    p[1] = (BYTE)(v >> 8);
+}
+//*********************************************************************************************
+static void st32(BYTE *p, DWORD v){
+    st16(p, (WORD)v);
+    st16(p + 2, (WORD)(v >> 16));
+}
+//*********************************************************************************************
+DSTATUS disk_initialize(BYTE pdrv){
+    return ramdisk ? 0 : STA_NOINIT;
+}
+//*********************************************************************************************
+DSTATUS disk_status(BYTE pdrv){
+    return ramdisk ? 0 : STA_NOINIT;
+}
+//*********************************************************************************************
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count){
+    if(sector + count > ramdiskSectors){
+        return RES_PARERR;
+    }
+    memcpy(buff, ramdisk + sector * 512, count * 512);
+    ramdiskReads += count;
+    return RES_OK;
+}
+//*********************************************************************************************
+// a power loss lets the sectors of the request before it reach the card
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count){
+    UINT n = count;
+    int cut = 0;
+
+    if(sector + count > ramdiskSectors){
+        return RES_PARERR;
+    }
+    if(ramdiskCut >= 0 && (DWORD)ramdiskCut < count){
+        n = (UINT)ramdiskCut;
+        cut = 1;
+    }
+    if(n){
+        memcpy(ramdisk + sector * 512, buff, n * 512);
+        memset(touched + sector, 1, n);
+        ramdiskWrites += n;
+        if(ramdiskWriteHook){
+            ramdiskWriteHook(sector, n);
+        }
+    }
+    if(cut){
+        ramdiskCut = -1;
+        longjmp(ramdiskPowerFail, 1);
+    }
+    if(ramdiskCut >= 0){
+        ramdiskCut -= count;
+    }
+    return RES_OK;
+}
+//*********************************************************************************************
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff){
+    switch(cmd){
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = ramdiskSectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = 512;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = ramdiskAu;
+        return RES_OK;
+    case CTRL_TRIM:                     // erased sectors read back as zeros
+        memset(ramdisk + ((DWORD *)buff)[0] * 512, 0, (((DWORD *)buff)[1] - ((DWORD *)buff)[0] + 1) * 512);
+        memset(touched + ((DWORD *)buff)[0], 1, ((DWORD *)buff)[1] - ((DWORD *)buff)[0] + 1);
+        return RES_OK;
+    case MMC_GET_CID:
+        memset(buff, ramdiskCid, 16);
+        return RES_OK;
+    }
+    return RES_PARERR;
+}
+//*********************************************************************************************
+DWORD get_fattime(void){
+    return fattime;
+}
+//*********************************************************************************************
+void ramdisk_init(DWORD sectors, DWORD auSectors){
+    free(ramdisk);
+    free(snap);
+    free(touched);
+    ramdisk = calloc(sectors, 512);
+    snap = 0;
+    touched = calloc(sectors, 1);
+    if(!ramdisk || !touched){
+        fprintf(stderr, "ramdisk: out of memory\n");
+        exit(2);
+    }
+    ramdiskSectors = sectors;
+    ramdiskAu = auSectors;
+    ramdiskReads = 0;
+    ramdiskWrites = 0;
+    ramdiskCut = -1;
+}
+//*********************************************************************************************
+// Volume without partition table, FSINFO in sector 1, root directory in
+// cluster 2. The volume serial keeps the write and geometry caches of ff.c
+// from taking one formatted image for another.
+void ramdisk_format(BYTE csize, DWORD serial){
+    DWORD fatsz, rsvd, data, clusters, i, au = ramdiskAu ? ramdiskAu : 1;
+    BYTE *bs = ramdisk, *fat;
+
+    fatsz = ((ramdiskSectors / csize + 2) * 4 + 511) / 512;
+    data = (32 + 2 * fatsz + au - 1) / au * au;
+    rsvd = data - 2 * fatsz;
+    clusters = (ramdiskSectors - data) / csize;
+    if(clusters < 65526){
+        fprintf(stderr, "ramdisk: %lu clusters are too few for FAT32\n", (unsigned long)clusters);
+        exit(2);
+    }
+    memset(ramdisk, 0, (data + csize) * 512);
+
+    memcpy(bs, "\xEB\x58\x90" "MSWIN4.1", 11);
+    st16(bs + 11, 512);
+    bs[13] = csize;
+    st16(bs + 14, (WORD)rsvd);
+    bs[16] = 2;
+    bs[21] = 0xF8;
+    st16(bs + 24, 63);
+    st16(bs + 26, 255);
+    st32(bs + 32, ramdiskSectors);
+    st32(bs + 36, fatsz);
+    st32(bs + 44, 2);
+    st16(bs + 48, 1);
+    st16(bs + 50, 6);
+    bs[64] = 0x80;
+    bs[66] = 0x29;
+    st32(bs + 67, serial);
+    memcpy(bs + 71, "NO NAME    FAT32   ", 19);
+    st16(bs + 510, 0xAA55);
+
+    bs = ramdisk + 512;                 // FSINFO
+    st32(bs, 0x41615252);
+    st32(bs + 484, 0x61417272);
+    st32(bs + 488, clusters - 1);
+    st32(bs + 492, 2);
+    st32(bs + 508, 0xAA550000);
+
+    for(i = 0; i < 2; i++){
+        fat = ramdisk + (rsvd + i * fatsz) * 512;
+        st32(fat, 0x0FFFFFF8);
+        st32(fat + 4, 0x0FFFFFFF);
+        st32(fat + 8, 0x0FFFFFFF);      // root directory
+    }
+    fattime = serial;
+    memset(touched, 1, ramdiskSectors);
+}
+//*********************************************************************************************
+void ramdisk_snapshot(void){
+    free(snap);
+    snap = malloc(ramdiskSectors * 512);
+    if(!snap){
+        fprintf(stderr, "ramdisk: out of memory\n");
+        exit(2);
+    }
+    memcpy(snap, ramdisk, ramdiskSectors * 512);
+    memset(touched, 0, ramdiskSectors);
+}
+//*********************************************************************************************
+void ramdisk_restore(void){
+    DWORD s;
+
+    for(s = 0; s < ramdiskSectors; s++){
+        if(touched[s]){
+            memcpy(ramdisk + s * 512, snap + s * 512, 512);
+            touched[s] = 0;
+        }
+    }
+}
+//*********************************************************************************************
+// No cluster may belong to two chains, every chain has to end after as many
+// clusters as its file size needs, and the FAT copies have to agree. Only
+// the root directory is checked. Allocated clusters in no chain are lost
+// space, not damage: FAT leaves them behind when the power fails while a
+// chain is stretched or cut. They are counted in *lost.
+int ramdisk_fsck(int verbose, DWORD *lost){
+    const BYTE *bs = ramdisk;
+    DWORD csize = bs[13], rsvd = bs[14] | bs[15] << 8, fatsz = ld32(bs + 36);
+    DWORD data = rsvd + 2 * fatsz, clusters = (ramdiskSectors - data) / csize;
+    const BYTE *fat = ramdisk + rsvd * 512;
+    BYTE *owner = calloc(clusters + 2, 1);
+    DWORD dir[64], c, n, size;
+    const BYTE *e, *end;
+    int ndir = 0, i, problems = 0;
+
+    if(memcmp(fat, fat + fatsz * 512, fatsz * 512)){
+        if(verbose) printf("fsck: the FAT copies differ\n");
+        problems++;
+    }
+    for(c = ld32(bs + 44); c >= 2 && c < clusters + 2 && !owner[c] && ndir < 64; c = ld32(fat + c * 4) & 0x0FFFFFFF){
+        owner[c] = 1;
+        dir[ndir++] = c;
+    }
+    for(i = 0; i < ndir; i++){
+        e = ramdisk + (data + (dir[i] - 2) * csize) * 512;
+        for(end = e + csize * 512; e < end && e[0]; e += 32){
+            if(e[0] == 0xE5 || (e[11] & 0x08)){
+                continue;               // deleted, volume label
+            }
+            size = ld32(e + 28);
+            n = 0;
+            for(c = (DWORD)(e[20] | e[21] << 8) << 16 | (e[26] | e[27] << 8); c >= 2 && c < clusters + 2;
+                c = ld32(fat + c * 4) & 0x0FFFFFFF){
+                if(owner[c]){
+                    if(verbose) printf("fsck: %.11s: cluster %lu cross-linked\n", e, (unsigned long)c);
+                    problems++;
+                    break;
+                }
+                owner[c] = 1;
+                n++;
+            }
+            if(n != (size + csize * 512 - 1) / (csize * 512)){
+                if(verbose) printf("fsck: %.11s: %lu bytes in %lu clusters\n", e, (unsigned long)size, (unsigned long)n);
+                problems++;
+            }
+        }
+        if(e < end){
+            break;                      // end of the directory
+        }
+    }
+    *lost = 0;
+    for(c = 2; c < clusters + 2; c++){
+        if((ld32(fat + c * 4) & 0x0FFFFFFF) && !owner[c]){
+            (*lost)++;
+        }
+    }
+    if(verbose && *lost){
+        printf("fsck: %lu clusters allocated but in no file\n", (unsigned long)*lost);
+    }
+    free(owner);
+    return problems;
+}
@@ -0,0 +1,33 @@
+/*
+ * ramdisk.h
+ *
+ *  SD card in host memory for the checks in tools/: the diskio.c functions,
+ *  a FAT32 formatter (the firmware builds without f_mkfs), a simple fsck,
+ *  and the buffers ff.c expects from the application. A power loss is
+ *  modelled by a count of sector writes after which disk_write() stops
+ *  halfway into its request and longjmps to ramdiskPowerFail.
+ */
+
+#ifndef RAMDISK_H_
+#define RAMDISK_H_
+
+#include <stdint.h>
+#include <setjmp.h>
+#include "../FatFS/ff.h"
+
+extern BYTE *ramdisk;                   // the image, 512 B sectors
+extern DWORD ramdiskSectors;
+extern DWORD ramdiskAu;                 // erase block from GET_BLOCK_SIZE, sectors
+extern BYTE ramdiskCid;                 // every byte of the card's CID
+extern DWORD ramdiskReads, ramdiskWrites;   // sectors since ramdisk_init
+extern long ramdiskCut;                 // sector writes left before the power fails, -1 = never
+extern jmp_buf ramdiskPowerFail;
+extern void (*ramdiskWriteHook)(DWORD sector, UINT count);  // every write that reaches the image
+
+void ramdisk_init(DWORD sectors, DWORD auSectors);
+void ramdisk_format(BYTE csize, DWORD serial);      // FAT32, data area on an AU boundary
+void ramdisk_snapshot(void);            // restore point for ramdisk_restore()
+void ramdisk_restore(void);             // back to the snapshot, only written sectors are copied
+int ramdisk_fsck(int verbose, DWORD *lost);    // problems in FAT and root directory, after f_flush()
+
+#endif /* RAMDISK_H_ */
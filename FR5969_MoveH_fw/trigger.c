@@ -0,0 +1,288 @@
+/*
+ * trigger.c
+ *
+ *  Event-triggered burst capture, see trigger.h.
+ */
+
+#include <msp430.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "trigger.h"
+#include "logbuf.h"
+#include "fixmath.h"
+
+#define STATE_IDLE          0       // filling the history
+#define STATE_BURST         1       // post window running, disk task draining
+#define STATE_TAIL          2       // post window over, draining up to tailEnd
+
+#define SRC_ACCEL           0
+#define SRC_GYRO            1
+#define SRC_EXT             2
+
+#pragma PERSISTENT(trigMg)
+uint16_t trigMg = 0;
+#pragma PERSISTENT(trigDps)
+uint16_t trigDps = 0;
+#pragma PERSISTENT(trigExt)
+bool trigExt = false;
+#pragma PERSISTENT(trigPreMs)
+uint16_t trigPreMs = 200;
+#pragma PERSISTENT(trigPostMs)
+uint16_t trigPostMs = 800;
+#pragma PERSISTENT(trigSlowDiv)
+uint16_t trigSlowDiv = 0;
+
+uint16_t trigBursts = 0;
+uint16_t trigOverruns = 0;
+
+#pragma PERSISTENT(trigRing)
+sample_t trigRing[TRIG_RING_LEN] = {0};
+
+static uint16_t head = 0;           // next slot written by trigger_feed
+static uint16_t fill = 0;           // valid history entries
+static uint16_t rd = 0;             // next slot written to the card
+static uint16_t tailEnd = 0;        // end of the burst in STATE_TAIL
+static uint8_t state = STATE_IDLE;
+static bool tagPending = false;
+static uint8_t source;
+static uint32_t triggerTime;
+static bool queued = false;         // a trigger during the tail waits for its end
+static uint16_t jumpAt = 0;         // end of the drained tail, rd goes on at jumpTo
+static uint16_t jumpTo = 0;         // first pre-trigger sample of the queued burst
+static uint8_t queuedSource;
+static uint32_t queuedTime;
+static uint32_t stopTime;
+static uint16_t slowCount = 0;
+static uint16_t mgScale;            // rangeG * 1000
+static uint16_t dpsScale;           // rangeDps
+static volatile bool extEvent = false;
+
+static const char * const sourceNames[] = {"accel", "gyro", "ext"};
+
+//*********************************************************************************************
+void trigger_set_mg(const char *value){
+    trigMg = atoi(value);
+}
+void trigger_set_dps(const char *value){
+    trigDps = atoi(value);
+}
+void trigger_set_ext(const char *value){
+    trigExt = atoi(value) != 0;
+}
+void trigger_set_pre(const char *value){
+    trigPreMs = atoi(value);
+}
+void trigger_set_post(const char *value){
+    trigPostMs = atoi(value);
+}
+void trigger_set_slow(const char *value){
+    trigSlowDiv = atoi(value);
+}
+//*********************************************************************************************
+bool trigger_enabled(void){
+    return trigMg || trigDps || trigExt;
+}
+//*********************************************************************************************
+uint8_t trigger_channels(void){
+    return (trigMg ? CH_ACCEL : 0) | (trigDps ? CH_GYRO : 0);
+}
+//*********************************************************************************************
+void trigger_start(uint8_t rangeG, uint16_t rangeDps){
+    mgScale = (uint16_t)rangeG * 1000;
+    dpsScale = rangeDps;
+    head = 0;
+    fill = 0;
+    rd = 0;
+    state = STATE_IDLE;
+    tagPending = false;
+    queued = false;
+    slowCount = 0;
+    trigBursts = 0;
+    trigOverruns = 0;
+    extEvent = false;
+
+    // P1.1 (LaunchPad S2) as external trigger, falling edge
+    if(trigExt){
+        P1DIR &= ~BIT1;
+        P1REN |= BIT1;
+        P1OUT |= BIT1;
+        P1IES |= BIT1;
+        P1IFG &= ~BIT1;
+        P1IE |= BIT1;
+    }
+    else{
+        P1IE &= ~BIT1;
+    }
+}
+//*********************************************************************************************
+static int16_t absMax3(int16_t x, int16_t y, int16_t z){
+    x = abs(x);
+    y = abs(y);
+    z = abs(z);
+    if(y > x) x = y;
+    if(z > x) x = z;
+    return x;
+}
+//*********************************************************************************************
+// trigger source of smp, 0xFF = none
+static uint8_t check(const sample_t *smp){
+    int16_t x, y, z;
+    uint16_t mag;
+
+    if(extEvent){
+        extEvent = false;
+        return SRC_EXT;
+    }
+    if(trigMg){
+        x = (int16_t)(((int32_t)smp->xAccel * mgScale) >> 15);
+        y = (int16_t)(((int32_t)smp->yAccel * mgScale) >> 15);
+        z = (int16_t)(((int32_t)smp->zAccel * mgScale) >> 15);
+        mag = isqrt32((int32_t)x * x + (int32_t)y * y + (int32_t)z * z);
+        if(abs((int16_t)(mag - 1000)) > trigMg){
+            return SRC_ACCEL;
+        }
+    }
+    if(trigDps){
+        if((((int32_t)absMax3(smp->xGyro, smp->yGyro, smp->zGyro) * dpsScale) >> 15) > trigDps){
+            return SRC_GYRO;
+        }
+    }
+    return 0xFF;
+}
+//*********************************************************************************************
+// oldest of the newest avail ring entries inside the pre-trigger window of smp
+static uint16_t windowStart(const sample_t *smp, uint16_t avail){
+    uint16_t start = head;
+    uint16_t n, prev;
+
+    if(avail){
+        start = (head + TRIG_RING_LEN - 1) % TRIG_RING_LEN;
+    }
+    for(n = 1; n < avail; n++){
+        prev = (start + TRIG_RING_LEN - 1) % TRIG_RING_LEN;
+        if(smp->time - trigRing[prev].time > trigPreMs){
+            break;
+        }
+        start = prev;
+    }
+    return start;
+}
+//*********************************************************************************************
+bool trigger_feed(const sample_t *smp){
+    uint16_t next = (head + 1) % TRIG_RING_LEN;
+    uint8_t src;
+
+    // never overwrite burst samples the disk task has not written yet
+    if(state != STATE_IDLE && next == rd){
+        trigOverruns++;
+    }
+    else{
+        trigRing[head] = *smp;
+        head = next;
+        if(fill < TRIG_RING_LEN - 1){
+            fill++;
+        }
+    }
+
+    src = check(smp);
+    if(state == STATE_TAIL && src != 0xFF){
+        if(!queued){
+            // the tail is drained first, then the new burst from its own
+            // pre-trigger window, which does not reach back into the tail
+            jumpAt = tailEnd;
+            jumpTo = windowStart(smp, (head + TRIG_RING_LEN - tailEnd) % TRIG_RING_LEN);
+            queuedSource = src;
+            queuedTime = smp->time;
+            queued = true;
+            trigBursts++;
+        }
+        stopTime = smp->time + trigPostMs;  // a queued burst is still running, it goes on
+        state = STATE_BURST;
+    }
+    else if(state == STATE_IDLE && src != 0xFF){
+        rd = windowStart(smp, fill);        // oldest history entry inside the pre-trigger window
+        source = src;
+        triggerTime = smp->time;
+        stopTime = smp->time + trigPostMs;
+        trigBursts++;
+        tagPending = true;
+        state = STATE_BURST;
+    }
+    else if(state == STATE_BURST){
+        if(src != 0xFF){
+            stopTime = smp->time + trigPostMs;      // retrigger extends the window
+        }
+        else if(smp->time > stopTime){
+            tailEnd = head;
+            state = STATE_TAIL;
+            if(rd == head && !queued){
+                fill = 0;                           // the whole history is on the card
+                state = STATE_IDLE;
+            }
+        }
+    }
+
+    if(state != STATE_IDLE || !trigSlowDiv){
+        return false;
+    }
+    if(++slowCount >= trigSlowDiv){
+        slowCount = 0;
+        return true;
+    }
+    return false;
+}
+//*********************************************************************************************
+bool trigger_write(FIL *fp){
+    uint16_t end;
+    uint8_t n;
+
+    if(state == STATE_IDLE){
+        return false;
+    }
+    if(tagPending){
+        logbuf_printf(fp, "%s,%u,%lu,%s\n", "burst", trigBursts, triggerTime, sourceNames[source]);
+        tagPending = false;
+    }
+    end = state == STATE_TAIL ? tailEnd : head;
+    for(n = 0; n < TRIG_WRITE_CHUNK && (queued || rd != end); n++){
+        if(queued && rd == jumpAt){         // tail done, the queued burst begins
+            rd = jumpTo;
+            source = queuedSource;
+            triggerTime = queuedTime;
+            queued = false;
+            logbuf_printf(fp, "%s,%u,%lu,%s\n", "burst", trigBursts, triggerTime, sourceNames[source]);
+            continue;
+        }
+        channels_write_sample(fp, &trigRing[rd]);
+        rd = (rd + 1) % TRIG_RING_LEN;
+    }
+    if(state == STATE_TAIL && rd == tailEnd && !queued){
+        fill = (head + TRIG_RING_LEN - tailEnd) % TRIG_RING_LEN;   // history taken after the burst
+        state = STATE_IDLE;
+    }
+    return trigger_backlog() != 0;
+}
+//*********************************************************************************************
+uint16_t trigger_backlog(void){
+    uint16_t end;
+
+    if(state == STATE_IDLE){
+        return 0;
+    }
+    end = state == STATE_TAIL ? tailEnd : head;
+    if(queued){
+        return (jumpAt + TRIG_RING_LEN - rd) % TRIG_RING_LEN + (end + TRIG_RING_LEN - jumpTo) % TRIG_RING_LEN + 1;
+    }
+    return (end + TRIG_RING_LEN - rd) % TRIG_RING_LEN + tagPending;
+}
+//*********************************************************************************************
+
+// external trigger
+#pragma vector = PORT1_VECTOR
+__interrupt void PORT1_ISR(void){
+    if(P1IFG & BIT1){
+        P1IFG &= ~BIT1;
+        extEvent = true;
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * trigger.h
+ *
+ *  Event-triggered burst capture. Every sample goes into a FRAM ring that
+ *  holds the pre-trigger history. A trigger (accel magnitude off 1 g by more
+ *  than trigMg, a gyro axis above trigDps, or a falling edge on P1.1 when
+ *  trigExt is set) starts a burst: the disk task writes a tag line
+ *
+ *      burst,<n>,<t_trigger_ms>,<accel|gyro|ext>
+ *
+ *  followed by the samples from trigPreMs before to trigPostMs after the
+ *  trigger, straight out of the FRAM ring. A trigger during the post window
+ *  extends it, one while the burst is still being written starts the next
+ *  burst right after it. Outside bursts every trigSlowDiv-th sample is logged
+ *  normally, 0 = none.
+ */
+
+#ifndef TRIGGER_H_
+#define TRIGGER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "./FatFS/ff.h"
+#include "channels.h"
+
+#define TRIG_RING_LEN       256     // samples of pre-trigger history and burst backlog, 32 B each
+#define TRIG_WRITE_CHUNK    16      // lines per disk task run, keeps sampling going while draining
+
+// FRAM settings, see config.h
+extern uint16_t trigMg;             // 0 = off
+extern uint16_t trigDps;            // 0 = off
+extern bool trigExt;
+extern uint16_t trigPreMs;
+extern uint16_t trigPostMs;
+extern uint16_t trigSlowDiv;
+
+extern uint16_t trigBursts;         // bursts in this session
+extern uint16_t trigOverruns;       // burst samples lost because the ring was full
+
+void trigger_set_mg(const char *value);         // "trig_mg="
+void trigger_set_dps(const char *value);        // "trig_dps="
+void trigger_set_ext(const char *value);        // "trig_ext="
+void trigger_set_pre(const char *value);        // "pre_ms="
+void trigger_set_post(const char *value);       // "post_ms="
+void trigger_set_slow(const char *value);       // "slow_div="
+
+bool trigger_enabled(void);
+uint8_t trigger_channels(void);                 // CH_* the trigger sources need
+void trigger_start(uint8_t rangeG, uint16_t rangeDps);     // session start
+bool trigger_feed(const sample_t *smp);         // every sample, true: also log it normally
+bool trigger_write(FIL *fp);                    // disk task, true while burst lines are pending
+uint16_t trigger_backlog(void);                 // burst lines not yet written
+
+#endif /* TRIGGER_H_ */
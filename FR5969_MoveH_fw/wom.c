@@ -0,0 +1,125 @@
+/*
+ * wom.c
+ *
+ *  Auto-record on motion, see wom.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "wom.h"
+#include "icm20948.h"
+
+#pragma PERSISTENT(womThresholdMg)
+uint16_t womThresholdMg = 0;
+#pragma PERSISTENT(womIdleSeconds)
+uint16_t womIdleSeconds = 60;
+bool womArmed = false;
+bool womSession = false;
+
+static uint16_t idleSeconds = 0;
+static uint16_t idleLsb = 0;        // womThresholdMg in accel LSB of the session range
+static int16_t winMin[3];           // accel extremes since the last tick, per axis
+static int16_t winMax[3];
+static bool winEmpty = true;
+
+// accel only, duty cycled, WOM against the previous sample
+static const icm_reg_t standbyTable[] = {
+    {0, ICM_INT_ENABLE,         0b00001000, 0xFF, 0, ICM_SRC_CONST},    // BIT[3]: WOM_INT_EN
+    {2, ICM_ACCEL_SMPLRT_DIV_1, 0,          0xFF, 0, ICM_SRC_CONST},
+    {2, ICM_ACCEL_SMPLRT_DIV_2, WOM_SMPLRT_DIV, 0xFF, 0, ICM_SRC_CONST},
+    {2, ICM_ACCEL_INTEL_CTRL,   0b00000011, 0xFF, 0, ICM_SRC_CONST},    // ACCEL_INTEL_EN, compare with previous sample
+    {2, ICM_ACCEL_WOM_THR,      0,          0xFF, 0, ICM_SRC_WOM_THR},
+    {0, ICM_LP_CONFIG,          0b01100000, 0xFF, 0, ICM_SRC_CONST},    // I2C master and accel duty cycled
+    {0, ICM_PWR_MGMT_1,         0b00100001, 0xFF, 0, ICM_SRC_CONST},    // BIT[5]: LP_EN, autoselect best clock
+    {0, ICM_PWR_MGMT_2,         0b00000111, 0xFF, 0, ICM_SRC_CONST},    // gyro off
+};
+
+// continuous accel/gyro like icmInitTable. WOM is off: at the full sample rate
+// two consecutive samples hardly ever differ by the threshold, inactivity is
+// judged from the logged samples instead.
+static const icm_reg_t wakeTable[] = {
+    {0, ICM_INT_ENABLE,         0b00000000, 0xFF, 0, ICM_SRC_CONST},
+    {2, ICM_ACCEL_INTEL_CTRL,   0b00000000, 0xFF, 0, ICM_SRC_CONST},
+    {0, ICM_LP_CONFIG,          0b01000000, 0xFF, 0, ICM_SRC_CONST},    // ACCEL/GYRO/I2CMST continuous
+    {0, ICM_PWR_MGMT_1,         0b00000001, 0xFF, 0, ICM_SRC_CONST},    // low power off
+    {0, ICM_PWR_MGMT_2,         0b00000000, 0xFF, 40, ICM_SRC_CONST},   // gyro on, 35 ms start-up
+    {2, ICM_ACCEL_SMPLRT_DIV_2, 0,          0xFF, 0, ICM_SRC_CONST},
+};
+
+//*********************************************************************************************
+void wom_set_threshold(const char *value){
+    womThresholdMg = atoi(value);
+}
+//*********************************************************************************************
+void wom_set_idle(const char *value){
+    womIdleSeconds = atoi(value);
+}
+//*********************************************************************************************
+void wom_standby(void){
+    uint16_t lsb;
+
+    if(!womThresholdMg){
+        return;
+    }
+    lsb = (womThresholdMg + 2) / 4;                 // 4 mg per LSB
+    icmWomThreshold = lsb > 255 ? 255 : lsb;
+    icm_apply(standbyTable, ICM_TABLE_LEN(standbyTable));
+    icm_read(0, ICM_INT_STATUS);                    // drop an event from the switch-over
+    womArmed = true;
+}
+//*********************************************************************************************
+void wom_wake(void){
+    if(!womArmed){
+        return;
+    }
+    icm_apply(wakeTable, ICM_TABLE_LEN(wakeTable));
+    womArmed = false;
+    idleSeconds = 0;
+}
+//*********************************************************************************************
+bool wom_motion(void){
+    return (icm_read(0, ICM_INT_STATUS) & 0x08) != 0;  // BIT[3]: WOM_INT
+}
+//*********************************************************************************************
+void wom_start(uint8_t rangeG){
+    uint32_t lsb = (uint32_t)womThresholdMg * 32768UL / ((uint32_t)rangeG * 1000);
+
+    idleLsb = lsb > 0x7FFF ? 0x7FFF : (uint16_t)lsb;
+    idleSeconds = 0;
+    winEmpty = true;
+}
+//*********************************************************************************************
+void wom_feed(const sample_t *smp){
+    const int16_t a[3] = {smp->xAccel, smp->yAccel, smp->zAccel};
+    uint8_t i;
+
+    for(i = 0; i < 3; i++){
+        if(winEmpty || a[i] < winMin[i]){
+            winMin[i] = a[i];
+        }
+        if(winEmpty || a[i] > winMax[i]){
+            winMax[i] = a[i];
+        }
+    }
+    winEmpty = false;
+}
+//*********************************************************************************************
+// moved if an axis spans more than the threshold within the last second,
+// turning counts too since gravity moves between the axes
+bool wom_idle_tick(void){
+    bool moved = false;
+    uint8_t i;
+
+    for(i = 0; i < 3 && !winEmpty; i++){
+        if((int32_t)winMax[i] - winMin[i] > idleLsb){
+            moved = true;
+        }
+    }
+    winEmpty = true;
+    if(moved){
+        idleSeconds = 0;
+        return false;
+    }
+    return ++idleSeconds >= womIdleSeconds;
+}
@@ -0,0 +1,37 @@
+/*
+ * wom.h
+ *
+ *  Auto-record on motion. While idle in standby the ICM20948 runs the
+ *  accelerometer alone in duty-cycled low power mode with its wake-on-motion
+ *  comparator armed; the 1 Hz tick checks WOM_INT and opens a session on
+ *  motion. A session opened this way is closed again after womIdleSeconds
+ *  in which no accel axis of the sampled data spans more than the threshold
+ *  within a second. The ICM20948 INT pin is not routed to the MSP430, so
+ *  WOM_INT is read over I2C from the tick instead of waking on a pin.
+ */
+
+#ifndef WOM_H_
+#define WOM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "channels.h"
+
+#define WOM_SMPLRT_DIV      100     // accel ODR in standby: 1125 Hz / (1 + div) = ~11 Hz
+
+extern uint16_t womThresholdMg;     // FRAM, 0 = auto-record off
+extern uint16_t womIdleSeconds;     // FRAM
+extern bool womArmed;               // sensor is in WOM standby
+extern bool womSession;             // running session was opened by motion
+
+void wom_set_threshold(const char *value);  // "wom_mg=" from CONFIG.TXT
+void wom_set_idle(const char *value);       // "idle_s=" from CONFIG.TXT
+
+void wom_standby(void);             // low power accel + WOM, no-op if auto-record is off
+void wom_wake(void);                // back to full rate accel/gyro, no-op if not armed
+bool wom_motion(void);              // WOM_INT since the last call, clears it
+void wom_start(uint8_t rangeG);     // session start, accel full scale in g
+void wom_feed(const sample_t *smp); // every sample of a motion session
+bool wom_idle_tick(void);           // 1 Hz during a motion session, true once idle long enough
+
+#endif /* WOM_H_ */
@@ -1,13 +0,0 @@
-/*
- * main.h
- *
- *  Created on: Sep 7, 2014
- *      Author: Nipun Gunawardena
- */
-
-#ifndef MAIN_H_
-#define MAIN_H_
-
-#define MCLK_FREQUENCY 16000000		// Used in mmc.c but is project specific
-
-#endif /* MAIN_H_ */